@@ -0,0 +1,389 @@
+// Microbenchmarks for the match making hot paths
+// Each case reports ns/op and heap allocations/op at a set of population sizes, so regressions show up before a release.
+//
+// Usage: MatchMakerMicroBench [--sizes 1000,100000,1000000] [--filter <substring>] [--seed <n>]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MatchMakingSystem.h"
+#include "RandomGenerator.h"
+#include "WorldClock.h"
+
+// ===== ALLOCATION COUNTING BEGIN =====
+
+static std::atomic<uint64_t> allocationCount{0};
+
+void* operator new(std::size_t size)
+{
+    ++allocationCount;
+    if (void* ptr = std::malloc(size == 0 ? 1 : size))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+// ===== ALLOCATION COUNTING END =====
+
+// Gives the benchmarks access to the private update phases of MatchMakingSystem
+struct FMatchMakingBenchAccess
+{
+    static std::vector<std::vector<VirtualPlayer*>>& DraftedPools(MatchMakingSystem& system) { return system.draftedPools; }
+    static void ClearDraftedPools(MatchMakingSystem& system)
+    {
+        for (std::vector<VirtualPlayer*>& pool : system.draftedPools)
+        {
+            for (VirtualPlayer* player : pool)
+            {
+                if (player->GetQueueHandle().poolIndex >= 0) { player->GetQueueHandle().Reset(); }
+            }
+        }
+        system.draftedPools.clear();
+    }
+    static VirtualPlayer* FindPlayer(MatchMakingSystem& system, int id) { return system.allPlayers.Find(id); }
+    static bool IsPlayerMatchable(const MatchMakingSystem& system, const VirtualPlayer& player, const std::vector<VirtualPlayer*>& pool) { return system.IsPlayerMatchable(player, pool); }
+    static void ReportToLeaderLists(MatchMakingSystem& system, EPlayerSortingType type, const VirtualPlayer& player) { system.ReportToLeaderLists(type, player); }
+    static void ScheduleStateEvent(MatchMakingSystem& system, uint64_t time, int playerId, EPlayerState state) { system.playersStateEvents.Schedule(playerId, time, state); }
+    static bool HasDueStateEvent(const MatchMakingSystem& system) { return system.playersStateEvents.GetNextTime() <= WorldTime::GetWorldTimeMillis(); }
+    static void Update_PlayerRoutine(MatchMakingSystem& system) { system.Update_PlayerRoutine(); }
+    static void Update_Matches(MatchMakingSystem& system) { system.Update_Matches(); }
+    static void StartMatch(MatchMakingSystem& system, const std::vector<VirtualPlayer*>& team) { system.StartMatch(team); }
+};
+
+using Bench = FMatchMakingBenchAccess;
+
+struct FBenchResult
+{
+    std::string name;
+    int population = 0;
+    uint64_t ops = 0;
+    double nanos = 0.0;
+    uint64_t allocations = 0;
+};
+
+// Measures a block of work that performs 'ops' operations
+template <typename Func>
+FBenchResult Measure(const std::string& name, int population, Func&& func)
+{
+    FBenchResult result;
+    result.name = name;
+    result.population = population;
+
+    uint64_t allocationsBefore = allocationCount.load();
+    auto startTime = std::chrono::steady_clock::now();
+    result.ops = func();
+    auto endTime = std::chrono::steady_clock::now();
+
+    result.allocations = allocationCount.load() - allocationsBefore;
+    result.nanos = std::chrono::duration<double, std::nano>(endTime - startTime).count();
+    return result;
+}
+
+void PrintResult(const FBenchResult& result)
+{
+    double ops = static_cast<double>((std::max)(result.ops, static_cast<uint64_t>(1)));
+    std::printf("%-40s %10d %10llu %14.1f %12.2f\n", result.name.c_str(), result.population,
+        static_cast<unsigned long long>(result.ops), result.nanos / ops, static_cast<double>(result.allocations) / ops);
+}
+
+// Fresh system with a created population, world time set to midday so a good share of players are online
+struct FBenchFixture
+{
+    MatchMakingSystem system = MatchMakingSystem(SkillBased);
+    int population = 0;
+
+    explicit FBenchFixture(int inPopulation) : population(inPopulation)
+    {
+        FMatchSetting setting;
+        setting.numTeams = 2;
+        setting.teamSize = 5;
+        setting.totalPlayer = setting.numTeams * setting.teamSize;
+        system.SetMatchSetting(setting);
+    }
+
+    std::vector<VirtualPlayer*> PickPlayers(int count)
+    {
+        std::vector<VirtualPlayer*> players;
+        players.reserve(count);
+        for (int i = 0; i < count; ++i)
+        {
+            players.push_back(Bench::FindPlayer(system, RandomInt(0, population - 1)));
+        }
+        return players;
+    }
+};
+
+void RunSize(int population, const std::string& filter, std::vector<FBenchResult>& results)
+{
+    auto ShouldRun = [&filter](const std::string& name) { return filter.empty() || name.find(filter) != std::string::npos; };
+    auto Record = [&results](const FBenchResult& result) { PrintResult(result); results.push_back(result); };
+
+    GetWorldClock().Reset(WorldTime::MILLISENCONDS_PER_DAY / 2);
+
+    FBenchFixture fixture(population);
+    MatchMakingSystem& system = fixture.system;
+
+    // population creation doubles as the CreatePlayer benchmark
+    FBenchResult createResult = Measure("CreatePlayer", population, [&]()
+    {
+        for (int i = 0; i < population; ++i)
+        {
+            system.CreatePlayer();
+        }
+        return static_cast<uint64_t>(population);
+    });
+    if (ShouldRun("CreatePlayer")) { Record(createResult); }
+
+    const int totalPlayer = system.GetMatchSetting().totalPlayer;
+
+    // IsPlayerMatchable against pools of different fill
+    for (int poolSize : {1, totalPlayer / 2, totalPlayer - 1})
+    {
+        std::string name = "IsPlayerMatchable/poolSize=" + std::to_string(poolSize);
+        if (!ShouldRun(name)) continue;
+
+        std::vector<VirtualPlayer*> pool = fixture.PickPlayers(poolSize);
+        std::vector<VirtualPlayer*> candidates = fixture.PickPlayers(1000);
+        Record(Measure(name, population, [&]()
+        {
+            uint64_t ops = 0;
+            int matchable = 0;
+            for (int r = 0; r < 100; ++r)
+            {
+                for (VirtualPlayer* candidate : candidates)
+                {
+                    matchable += Bench::IsPlayerMatchable(system, *candidate, pool) ? 1 : 0;
+                    ++ops;
+                }
+            }
+            if (matchable < 0) std::cout << matchable; // keep the result alive
+            return ops;
+        }));
+    }
+
+    // TryAssignPlayerToTeam scanning a number of full pools before opening a new one
+    for (int numPools : {10, 100, 1000})
+    {
+        std::string name = "TryAssignPlayerToTeam/pools=" + std::to_string(numPools);
+        if (!ShouldRun(name)) continue;
+
+        std::vector<std::vector<VirtualPlayer*>>& pools = Bench::DraftedPools(system);
+        pools.assign(numPools, fixture.PickPlayers(totalPlayer));
+
+        std::vector<VirtualPlayer*> candidates;
+        for (VirtualPlayer* player : fixture.PickPlayers(2000))
+        {
+            if (player->GetState() == EPlayerState::Online)
+            {
+                player->SetState(EPlayerState::InQueue);
+            }
+            if (player->GetState() == EPlayerState::InQueue)
+            {
+                candidates.push_back(player);
+            }
+        }
+
+        Record(Measure(name, population, [&]()
+        {
+            for (VirtualPlayer* candidate : candidates)
+            {
+                system.TryAssignPlayerToTeam(candidate);
+            }
+            return static_cast<uint64_t>(candidates.size());
+        }));
+        Bench::ClearDraftedPools(system);
+    }
+
+    // RemovePlayerFromQueue with every player queued
+    if (ShouldRun("RemovePlayerFromQueue"))
+    {
+        for (int i = 0; i < population; ++i)
+        {
+            system.AddPlayerToQueue(Bench::FindPlayer(system, i));
+        }
+        std::vector<VirtualPlayer*> toRemove = fixture.PickPlayers(1000);
+        Record(Measure("RemovePlayerFromQueue", population, [&]()
+        {
+            for (VirtualPlayer* player : toRemove)
+            {
+                system.RemovePlayerFromQueue(player);
+            }
+            return static_cast<uint64_t>(toRemove.size());
+        }));
+        for (int i = 0; i < population; ++i)
+        {
+            system.RemovePlayerFromQueue(Bench::FindPlayer(system, i));
+        }
+    }
+
+    // ReportToLeaderLists for random players
+    if (ShouldRun("ReportToLeaderLists"))
+    {
+        std::vector<VirtualPlayer*> players = fixture.PickPlayers(10000);
+        Record(Measure("ReportToLeaderLists", population, [&]()
+        {
+            for (VirtualPlayer* player : players)
+            {
+                Bench::ReportToLeaderLists(system, TotalScore, *player);
+            }
+            return static_cast<uint64_t>(players.size());
+        }));
+    }
+
+    // exact rank lookups and a mid-pack page of the full population ranking
+    if (ShouldRun("GetPlayerRank"))
+    {
+        std::vector<VirtualPlayer*> players = fixture.PickPlayers(10000);
+        Record(Measure("GetPlayerRank", population, [&]()
+        {
+            for (VirtualPlayer* player : players)
+            {
+                system.GetPlayerRank(TotalScore, player->GetId());
+            }
+            return static_cast<uint64_t>(players.size());
+        }));
+    }
+
+    if (ShouldRun("GetPlayersByRank"))
+    {
+        std::vector<int> page;
+        Record(Measure("GetPlayersByRank", population, [&]()
+        {
+            const uint64_t pages = 1000;
+            for (uint64_t i = 0; i < pages; ++i)
+            {
+                system.GetPlayersByRank(TotalScore, static_cast<size_t>(population / 2), 100, page);
+            }
+            return pages;
+        }));
+    }
+
+    // Update_PlayerRoutine draining one due event per player
+    if (ShouldRun("Update_PlayerRoutine"))
+    {
+        GetWorldClock().Advance(WorldTime::MILLISENCONDS_PER_MINUTE);
+        uint64_t now = WorldTime::GetWorldTimeMillis();
+        for (int i = 0; i < population; ++i)
+        {
+            const VirtualPlayer* player = Bench::FindPlayer(system, i);
+            EPlayerState newState = player->GetState() == EPlayerState::Offline ? EPlayerState::Online : EPlayerState::Offline;
+            Bench::ScheduleStateEvent(system, now, i, newState);
+        }
+
+        Record(Measure("Update_PlayerRoutine", population, [&]()
+        {
+            while (Bench::HasDueStateEvent(system))
+            {
+                Bench::Update_PlayerRoutine(system);
+            }
+            return static_cast<uint64_t>(population);
+        }));
+    }
+
+    // Update_Matches concluding matches started from most of the population
+    if (ShouldRun("Update_Matches"))
+    {
+        int numMatches = population / totalPlayer;
+        for (int m = 0; m < numMatches; ++m)
+        {
+            std::vector<VirtualPlayer*> team;
+            for (int p = 0; p < totalPlayer; ++p)
+            {
+                team.push_back(Bench::FindPlayer(system, m * totalPlayer + p));
+            }
+            Bench::StartMatch(system, team);
+        }
+
+        // ticks where none of the ongoing matches is finishing yet
+        Record(Measure("Update_Matches_NoneDue", population, [&]()
+        {
+            const uint64_t ticks = 1000;
+            for (uint64_t i = 0; i < ticks; ++i)
+            {
+                Bench::Update_Matches(system);
+            }
+            return ticks;
+        }));
+
+        // every match lasts at most 1.5x the average duration
+        GetWorldClock().Advance(static_cast<uint64_t>(system.GetMatchSetting().matchDuration) * 2);
+        size_t ongoingMatches = system.GetOngoingMatches().Size();
+        Record(Measure("Update_Matches", population, [&]()
+        {
+            Bench::Update_Matches(system);
+            return static_cast<uint64_t>(ongoingMatches);
+        }));
+
+        // same batch ended on every hardware thread
+        const int numThreads = static_cast<int>((std::max)(std::thread::hardware_concurrency(), 1u));
+        FWorldSetting worldSetting = system.GetWorldSetting();
+        worldSetting.workerThreads = numThreads;
+        system.SetWorldSetting(worldSetting);
+        for (int m = 0; m < numMatches; ++m)
+        {
+            std::vector<VirtualPlayer*> team;
+            for (int p = 0; p < totalPlayer; ++p)
+            {
+                team.push_back(Bench::FindPlayer(system, m * totalPlayer + p));
+            }
+            Bench::StartMatch(system, team);
+        }
+        GetWorldClock().Advance(static_cast<uint64_t>(system.GetMatchSetting().matchDuration) * 2);
+        ongoingMatches = system.GetOngoingMatches().Size();
+        Record(Measure("Update_Matches_" + std::to_string(numThreads) + "Threads", population, [&]()
+        {
+            Bench::Update_Matches(system);
+            return static_cast<uint64_t>(ongoingMatches);
+        }));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<int> sizes = {1000, 100000, 1000000};
+    std::string filter;
+    uint64_t seed = 12345;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+        if (arg == "--sizes")
+        {
+            sizes.clear();
+            size_t start = 0;
+            while (start < value.size())
+            {
+                size_t end = value.find(',', start);
+                sizes.push_back(std::atoi(value.substr(start, end - start).c_str()));
+                start = end == std::string::npos ? value.size() : end + 1;
+            }
+        }
+        else if (arg == "--filter") { filter = value; }
+        else if (arg == "--seed")   { seed = std::strtoull(value.c_str(), nullptr, 10); }
+    }
+
+    SeedRandomGenerator(seed);
+    GetWorldClock().SetMode(EClockMode::FixedStep);
+
+    std::printf("%-40s %10s %10s %14s %12s\n", "case", "players", "ops", "ns/op", "allocs/op");
+    std::vector<FBenchResult> results;
+    for (int population : sizes)
+    {
+        RunSize(population, filter, results);
+    }
+    return 0;
+}
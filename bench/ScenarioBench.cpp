@@ -0,0 +1,396 @@
+// End to end scenario benchmark for the match making simulation
+// Runs a fixed set of scenarios for a number of game days and writes a JSON report. A compare mode diffs two reports and
+// flags regressions above a threshold, so changes to the system can be judged against a recorded baseline.
+//
+// Usage:
+//   MatchMakerScenarioBench [--out report.json] [--days <n>] [--populations 10000,100000,1000000] [--filter <substring>]
+//                           [--seed <n>] [--clock fixed|event] [--step <ms>]
+//   MatchMakerScenarioBench --compare <baseline.json> <current.json> [--threshold <percent>] [--min-delta-us <us>]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "Logger.h"
+#include "MatchMakingSystem.h"
+#include "RandomGenerator.h"
+#include "WorldClock.h"
+
+struct FScenario
+{
+    std::string name;
+    int population = 0;
+    int numTeams = 2;
+    int teamSize = 1;
+    EMatchMakeAlgorithm algorithm = LIFO;
+};
+
+struct FScenarioResult
+{
+    std::string name;
+    std::map<std::string, double> metrics;
+};
+
+// metrics where a bigger number is the better result, everything else is treated as lower-is-better
+static bool IsHigherBetter(const std::string& metric)
+{
+    return metric == "ticks_per_sec" || metric == "events_per_sec" || metric == "matches_per_sec";
+}
+
+static bool EndsWith(const std::string& text, const char* suffix)
+{
+    const size_t length = std::char_traits<char>::length(suffix);
+    return text.size() >= length && text.compare(text.size() - length, length, suffix) == 0;
+}
+
+// absolute change a regression has to exceed, anything up to it is run to run noise for the metric's unit
+static double GetMinDelta(const std::string& metric, double minMicrosDelta)
+{
+    if (EndsWith(metric, "_us")) return minMicrosDelta;
+    if (EndsWith(metric, "_ms")) return 1.0; // one world millisecond, the resolution of the lateness histogram
+    if (EndsWith(metric, "_mb")) return 1.0;
+    if (EndsWith(metric, "_sec")) return 0.05;
+    if (metric == "peak_event_backlog") return 1.0;
+    return 0.0;
+}
+
+static const char* ToString(EMatchMakeAlgorithm algorithm)
+{
+    switch (algorithm)
+    {
+    case LIFO:          return "LIFO";
+    case FIFO:          return "FIFO";
+    case SkillBased:    return "SkillBased";
+    case TraitGrouping: return "TraitGrouping";
+    }
+    return "Unknown";
+}
+
+// ===== PEAK RSS BEGIN =====
+
+// Clears the peak RSS counter where the platform allows it, so each scenario reports its own peak
+static void ResetPeakRss()
+{
+#if defined(__linux__)
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    if (clearRefs)
+    {
+        clearRefs << "5";
+    }
+#endif
+}
+
+// Peak resident set size in bytes
+static double GetPeakRssBytes()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return static_cast<double>(counters.PeakWorkingSetSize);
+    }
+    return 0.0;
+#elif defined(__linux__)
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+    {
+        if (line.rfind("VmHWM:", 0) == 0)
+        {
+            return std::atof(line.c_str() + 6) * 1024.0; // reported in kB
+        }
+    }
+    return 0.0;
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<double>(usage.ru_maxrss); // bytes on macOS
+#endif
+}
+
+// ===== PEAK RSS END =====
+
+// ===== JSON BEGIN =====
+
+static void WriteReport(const std::string& path, const std::vector<FScenarioResult>& results, int days, uint64_t seed)
+{
+    std::ofstream out(path);
+    out.precision(10);
+    out << "{\n  \"days\": " << days << ",\n  \"seed\": " << seed << ",\n  \"scenarios\": [\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        out << "    {\"name\": \"" << results[i].name << "\"";
+        for (const auto& [metric, value] : results[i].metrics)
+        {
+            out << ", \"" << metric << "\": " << value;
+        }
+        out << "}" << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+
+// Reads back the reports written above. Only understands the flat layout of WriteReport
+static bool ReadReport(const std::string& path, std::vector<FScenarioResult>& outResults)
+{
+    std::ifstream in(path);
+    if (!in)
+    {
+        std::cout << "Can't open " << path << "\n";
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    const std::string text = buffer.str();
+
+    size_t pos = text.find("\"scenarios\"");
+    if (pos == std::string::npos) return false;
+
+    while ((pos = text.find('{', pos)) != std::string::npos)
+    {
+        size_t end = text.find('}', pos);
+        if (end == std::string::npos) return false;
+
+        FScenarioResult result;
+        std::string entry = text.substr(pos + 1, end - pos - 1);
+        size_t cursor = 0;
+        while ((cursor = entry.find('"', cursor)) != std::string::npos)
+        {
+            size_t keyEnd = entry.find('"', cursor + 1);
+            std::string key = entry.substr(cursor + 1, keyEnd - cursor - 1);
+            size_t valueStart = entry.find_first_not_of(" :", keyEnd + 1);
+            if (entry[valueStart] == '"')
+            {
+                size_t valueEnd = entry.find('"', valueStart + 1);
+                if (key == "name") result.name = entry.substr(valueStart + 1, valueEnd - valueStart - 1);
+                cursor = valueEnd + 1;
+            }
+            else
+            {
+                result.metrics[key] = std::atof(entry.c_str() + valueStart);
+                cursor = entry.find_first_of(",", valueStart);
+                if (cursor == std::string::npos) break;
+            }
+        }
+        outResults.push_back(result);
+        pos = end + 1;
+    }
+    return true;
+}
+
+// ===== JSON END =====
+
+static int CompareReports(const std::string& baselinePath, const std::string& currentPath, double thresholdPercent, double minMicrosDelta)
+{
+    std::vector<FScenarioResult> baseline;
+    std::vector<FScenarioResult> current;
+    if (!ReadReport(baselinePath, baseline) || !ReadReport(currentPath, current))
+    {
+        return 2;
+    }
+
+    int regressions = 0;
+    std::printf("%-36s %-18s %14s %14s %9s\n", "scenario", "metric", "baseline", "current", "change");
+    for (const FScenarioResult& base : baseline)
+    {
+        auto it = std::find_if(current.begin(), current.end(), [&base](const FScenarioResult& r) { return r.name == base.name; });
+        if (it == current.end())
+        {
+            std::printf("%-36s missing from %s\n", base.name.c_str(), currentPath.c_str());
+            continue;
+        }
+
+        // rates of short runs swing with a few milliseconds of wall time, they only count once the wall time moved too
+        auto baseWall = base.metrics.find("wall_time_sec");
+        auto currentWall = it->metrics.find("wall_time_sec");
+        const bool bWallTimeChanged = baseWall == base.metrics.end() || currentWall == it->metrics.end()
+            || std::abs(currentWall->second - baseWall->second) > GetMinDelta("wall_time_sec", minMicrosDelta);
+
+        for (const auto& [metric, baseValue] : base.metrics)
+        {
+            auto metricIt = it->metrics.find(metric);
+            if (metricIt == it->metrics.end() || baseValue == 0.0) continue;
+
+            double change = (metricIt->second - baseValue) / baseValue * 100.0;
+            bool bRegressed = IsHigherBetter(metric) ? change < -thresholdPercent : change > thresholdPercent;
+            bRegressed = bRegressed && std::abs(metricIt->second - baseValue) > GetMinDelta(metric, minMicrosDelta);
+            bRegressed = bRegressed && (!IsHigherBetter(metric) || bWallTimeChanged);
+            regressions += bRegressed ? 1 : 0;
+            std::printf("%-36s %-18s %14.2f %14.2f %+8.1f%%%s\n", base.name.c_str(), metric.c_str(), baseValue, metricIt->second, change,
+                bRegressed ? "  REGRESSION" : "");
+        }
+    }
+
+    std::printf("\n%d regression(s) above %.1f%%\n", regressions, thresholdPercent);
+    return regressions > 0 ? 1 : 0;
+}
+
+static FScenarioResult RunScenario(const FScenario& scenario, int days, uint64_t seed, EClockMode clockMode, uint64_t fixedStepMillis)
+{
+    SeedRandomGenerator(seed);
+    FActivityLog::SetEnabled(false); // same as the headless runner default
+    GetWorldClock().SetMode(clockMode);
+    GetWorldClock().SetFixedStep(fixedStepMillis);
+    GetWorldClock().Reset(0);
+    ResetPeakRss();
+
+    MatchMakingSystem* MMSim = new MatchMakingSystem(scenario.algorithm);
+    FMatchSetting matchSetting;
+    matchSetting.numTeams = scenario.numTeams;
+    matchSetting.teamSize = scenario.teamSize;
+    matchSetting.totalPlayer = scenario.numTeams * scenario.teamSize;
+    MMSim->SetMatchSetting(matchSetting);
+    MMSim->AddToPlayerCreationQueue(scenario.population);
+
+    const uint64_t endTime = static_cast<uint64_t>(days) * WorldTime::MILLISENCONDS_PER_DAY;
+    FValueHistogram tickDurations(0.1, 1000000); // microseconds, 0.1us buckets up to 100ms
+    uint64_t ticks = 0;
+
+    auto runStartTime = std::chrono::steady_clock::now();
+    while (WorldTime::GetWorldTimeMillis() < endTime)
+    {
+        if (clockMode == EClockMode::EventDriven)
+        {
+            GetWorldClock().AdvanceTo((std::min)(MMSim->GetNextEventTime(), endTime));
+        }
+        else
+        {
+            GetWorldClock().Update();
+        }
+
+        auto tickStartTime = std::chrono::steady_clock::now();
+        MMSim->Update();
+        tickDurations.Add(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - tickStartTime).count());
+        ++ticks;
+    }
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStartTime).count();
+
+    const FSystemCounters& counters = MMSim->GetCounters();
+    FScenarioResult result;
+    result.name = scenario.name;
+    result.metrics["wall_time_sec"] = wallSeconds;
+    result.metrics["ticks_per_sec"] = static_cast<double>(ticks) / wallSeconds;
+    result.metrics["events_per_sec"] = static_cast<double>(counters.stateEventsProcessed) / wallSeconds;
+    result.metrics["matches_per_sec"] = static_cast<double>(counters.matchesCompleted) / wallSeconds;
+    result.metrics["peak_rss_mb"] = GetPeakRssBytes() / (1024.0 * 1024.0);
+    result.metrics["update_p50_us"] = tickDurations.GetPercentile(0.50);
+    result.metrics["update_p99_us"] = tickDurations.GetPercentile(0.99);
+    result.metrics["event_lateness_p99_ms"] = MMSim->GetHistograms().stateEventLateness.GetPercentile(0.99);
+    result.metrics["peak_event_backlog"] = static_cast<double>(counters.peakStateEventBacklog);
+
+    delete MMSim;
+    return result;
+}
+
+static std::vector<int> ParseIntList(const std::string& value)
+{
+    std::vector<int> list;
+    size_t start = 0;
+    while (start < value.size())
+    {
+        size_t end = value.find(',', start);
+        list.push_back(std::atoi(value.substr(start, end - start).c_str()));
+        start = end == std::string::npos ? value.size() : end + 1;
+    }
+    return list;
+}
+
+int main(int argc, char** argv)
+{
+    std::string outPath = "scenario_report.json";
+    std::string filter;
+    std::vector<int> populations = {10000, 100000, 1000000};
+    int days = 1;
+    uint64_t seed = 12345;
+    EClockMode clockMode = EClockMode::FixedStep;
+    uint64_t fixedStepMillis = 16;
+    double thresholdPercent = 5.0;
+    double minMicrosDelta = 1.0;
+    std::string compareBaseline;
+    std::string compareCurrent;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--compare" && i + 2 < argc)
+        {
+            compareBaseline = argv[++i];
+            compareCurrent = argv[++i];
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            std::cout << "Missing value for " << arg << "\n";
+            return 2;
+        }
+        std::string value = argv[++i];
+        if      (arg == "--out")         { outPath = value; }
+        else if (arg == "--filter")      { filter = value; }
+        else if (arg == "--populations") { populations = ParseIntList(value); }
+        else if (arg == "--days")        { days = std::atoi(value.c_str()); }
+        else if (arg == "--seed")        { seed = std::strtoull(value.c_str(), nullptr, 10); }
+        else if (arg == "--step")        { fixedStepMillis = std::strtoull(value.c_str(), nullptr, 10); }
+        else if (arg == "--threshold")   { thresholdPercent = std::atof(value.c_str()); }
+        else if (arg == "--min-delta-us") { minMicrosDelta = std::atof(value.c_str()); }
+        else if (arg == "--clock")       { clockMode = value == "event" ? EClockMode::EventDriven : EClockMode::FixedStep; }
+        else
+        {
+            std::cout << "Unknown option: " << arg << "\n";
+            return 2;
+        }
+    }
+
+    if (!compareBaseline.empty())
+    {
+        return CompareReports(compareBaseline, compareCurrent, thresholdPercent, minMicrosDelta);
+    }
+
+    // every population x match format x algorithm
+    std::vector<FScenario> scenarios;
+    for (int population : populations)
+    {
+        for (int teamSize : {1, 5})
+        {
+            for (EMatchMakeAlgorithm algorithm : {LIFO, FIFO, SkillBased, TraitGrouping})
+            {
+                FScenario scenario;
+                scenario.population = population;
+                scenario.teamSize = teamSize;
+                scenario.algorithm = algorithm;
+                scenario.name = std::to_string(population) + "/" + std::to_string(teamSize) + "v" + std::to_string(teamSize) + "/" + ToString(algorithm);
+                scenarios.push_back(scenario);
+            }
+        }
+    }
+
+    std::vector<FScenarioResult> results;
+    for (const FScenario& scenario : scenarios)
+    {
+        if (!filter.empty() && scenario.name.find(filter) == std::string::npos) continue;
+
+        FScenarioResult result = RunScenario(scenario, days, seed, clockMode, fixedStepMillis);
+        std::printf("%-36s wall %8.2fs  ticks/s %10.1f  events/s %12.1f  matches/s %10.1f  rss %8.1fMB  p50 %8.1fus  p99 %8.1fus\n",
+            result.name.c_str(), result.metrics["wall_time_sec"], result.metrics["ticks_per_sec"], result.metrics["events_per_sec"],
+            result.metrics["matches_per_sec"], result.metrics["peak_rss_mb"], result.metrics["update_p50_us"], result.metrics["update_p99_us"]);
+        results.push_back(result);
+        WriteReport(outPath, results, days, seed); // rewrite after every scenario so a long run that gets cut still leaves a report
+    }
+
+    std::cout << "Report written to " << outPath << "\n";
+    return 0;
+}
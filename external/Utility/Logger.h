@@ -1,7 +1,12 @@
 #pragma once
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <sstream>
+#include <vector>
 
 struct FScopedPerfTimer
 {
@@ -33,6 +38,128 @@ struct FSimpleLogger
     }
 };
 
+// Fixed size histogram, so long runs don't keep every sample around. The unit is up to the caller, bucketWidth is in
+// that unit and anything above the last bucket is counted in it
+struct FValueHistogram
+{
+    explicit FValueHistogram(double inBucketWidth = 1.0, size_t numBuckets = 100000)
+        : buckets(numBuckets, 0), bucketWidth(inBucketWidth) {}
+
+    std::vector<uint64_t> buckets;
+    double bucketWidth = 1.0;
+    uint64_t count = 0;
+    double total = 0.0;
+    double max = 0.0;
+
+    void Add(double value)
+    {
+        const double index = (std::clamp)(value / bucketWidth, 0.0, static_cast<double>(buckets.size() - 1));
+        ++buckets[static_cast<size_t>(index)];
+        ++count;
+        total += value;
+        max = (std::max)(max, value);
+    }
+
+    // both histograms need the same bucket layout
+    void Merge(const FValueHistogram& other)
+    {
+        for (size_t i = 0; i < buckets.size() && i < other.buckets.size(); ++i)
+        {
+            buckets[i] += other.buckets[i];
+        }
+        count += other.count;
+        total += other.total;
+        max = (std::max)(max, other.max);
+    }
+
+    double GetAverage() const { return count == 0 ? 0.0 : total / static_cast<double>(count); }
+
+    // upper bound of the bucket containing the given percentile (0-1), never above the largest value added
+    double GetPercentile(double percentile) const
+    {
+        if (count == 0) return 0.0;
+        uint64_t target = static_cast<uint64_t>(percentile * static_cast<double>(count - 1));
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i < buckets.size(); ++i)
+        {
+            cumulative += buckets[i];
+            if (cumulative > target)
+            {
+                return (std::min)(static_cast<double>(i + 1) * bucketWidth, max);
+            }
+        }
+        return max;
+    }
+};
+
+// Count, total, max and a coarse distribution in about a kilobyte, cheap enough to copy and merge while a run is
+// observed. Buckets are a quarter of a power of two wide, so percentiles are at most 25% above the exact value
+struct FValueSummary
+{
+    static constexpr int SUB_BUCKETS = 4;
+    static constexpr int NUM_BUCKETS = 1 + 32 * SUB_BUCKETS; // values below 1, then every power of two up to 2^32
+
+    std::array<uint64_t, NUM_BUCKETS> buckets{};
+    uint64_t count = 0;
+    double total = 0.0;
+    double max = 0.0;
+
+    void Add(double value)
+    {
+        ++buckets[GetBucket(value)];
+        ++count;
+        total += value;
+        max = (std::max)(max, value);
+    }
+
+    void Merge(const FValueSummary& other)
+    {
+        for (int i = 0; i < NUM_BUCKETS; ++i)
+        {
+            buckets[i] += other.buckets[i];
+        }
+        count += other.count;
+        total += other.total;
+        max = (std::max)(max, other.max);
+    }
+
+    double GetAverage() const { return count == 0 ? 0.0 : total / static_cast<double>(count); }
+
+    // upper bound of the bucket containing the given percentile (0-1), never above the largest value added
+    double GetPercentile(double percentile) const
+    {
+        if (count == 0) return 0.0;
+        uint64_t target = static_cast<uint64_t>(percentile * static_cast<double>(count - 1));
+        uint64_t cumulative = 0;
+        for (int i = 0; i < NUM_BUCKETS; ++i)
+        {
+            cumulative += buckets[i];
+            if (cumulative > target)
+            {
+                return (std::min)(GetBucketUpperBound(i), max);
+            }
+        }
+        return max;
+    }
+
+    static int GetBucket(double value)
+    {
+        if (!(value >= 1.0)) return 0;
+        int exponent = 0;
+        const double mantissa = std::frexp(value, &exponent); // value = mantissa * 2^exponent, mantissa in [0.5, 1)
+        const int subBucket = static_cast<int>((mantissa * 2.0 - 1.0) * SUB_BUCKETS);
+        return (std::min)(1 + (exponent - 1) * SUB_BUCKETS + subBucket, NUM_BUCKETS - 1);
+    }
+
+    static double GetBucketUpperBound(int bucket)
+    {
+        if (bucket == 0) return 1.0;
+        const int octave = (bucket - 1) / SUB_BUCKETS;
+        const int subBucket = (bucket - 1) % SUB_BUCKETS;
+        return std::ldexp(1.0 + static_cast<double>(subBucket + 1) / SUB_BUCKETS, octave);
+    }
+};
+
 // Macros to simplify usage
 #define START_PERF_MEASURE(NAME) FScopedPerfTimer PerfTimer_##NAME(#NAME);
 #define SIMPLOG(NAME, TEXT) FSimpleLogger Logger_##NAME(#NAME, ToString(TEXT));
@@ -1,6 +1,6 @@
 #include "RandomGenerator.h"
 
-Xoshiro256SS rng;
+thread_local Xoshiro256SS rng;
 
 void SeedRandomGenerator(uint64_t seed)
 {
@@ -1,11 +1,29 @@
 #pragma once
-#include "Xoshiro256SS.h"
+#include "Xoshiro256ss.h"
 
-extern Xoshiro256SS rng;
+#include <utility>
 
-// Init RNG with a seed
+// every thread draws from its own generator, threads other than the one seeded start from a zero state
+extern thread_local Xoshiro256SS rng;
+
+// Init RNG with a seed, for the calling thread
 void SeedRandomGenerator(uint64_t seed);
 
+// Makes a saved generator state the calling thread's generator for the scope and saves it back at the end, so a
+// simulation that runs on whichever thread is free keeps its own reproducible stream
+class FScopedRandomGenerator
+{
+public:
+    explicit FScopedRandomGenerator(Xoshiro256SS& inState) : state(inState) { std::swap(rng, state); }
+    ~FScopedRandomGenerator() { std::swap(rng, state); }
+
+    FScopedRandomGenerator(const FScopedRandomGenerator&) = delete;
+    FScopedRandomGenerator& operator=(const FScopedRandomGenerator&) = delete;
+
+private:
+    Xoshiro256SS& state;
+};
+
 // Generate a random number in range based on type of value passed in
 int RandomInt(int min, int max);
 uint64_t RandomInt64(uint64_t min, uint64_t max);
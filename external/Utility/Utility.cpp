@@ -20,21 +20,6 @@ const std::unordered_map<EColor, FColor> NamedColorMap = {
     {White,         FColor(255, 255, 255)},
 };
 
-ImVec4 ColorAsImVec4(FColor color)
-{
-    return {
-        static_cast<float>(color.r) / 255,
-        static_cast<float>(color.g) / 255,
-        static_cast<float>(color.b) / 255,
-        static_cast<float>(color.a) / 255
-    };
-}
-
-ImVec4 ColorAsImVec4(EColor colorName)
-{
-    return ColorAsImVec4(GetColor(colorName));
-}
-
 bool CheckUpdateDelay_RealTime(const int& interval, std::chrono::steady_clock::time_point& lastUpdateTimeRef)
 {
     auto now = std::chrono::steady_clock::now();
@@ -2,7 +2,6 @@
 
 #include <chrono>
 #include <unordered_map>
-#include "imgui.h"
 
 // Common struct representing a color with transparency
 struct FColor
@@ -53,8 +52,6 @@ static float* ColorAsFloatArray(FColor color){
     colorVec[3] = static_cast<float>(color.a) / 255.0f;
     return colorVec;
 };
-ImVec4 ColorAsImVec4(FColor color);
-ImVec4 ColorAsImVec4(EColor colorName);
 
 // returns true if delay passes, this is not affected by in game time scale, useful for UI display
 bool CheckUpdateDelay_RealTime(const int& interval, std::chrono::steady_clock::time_point& lastUpdateTimeRef);
@@ -4,11 +4,25 @@ void WorldClock::Update()
 {
     if (bIsPaused) return;
 
+    if (mode == EClockMode::FixedStep)
+    {
+        worldTimeMillis += fixedStepMillis;
+        return;
+    }
+
+    if (mode == EClockMode::EventDriven)
+    {
+        return;
+    }
+
     auto now = std::chrono::steady_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastUpdateTime);
+    std::chrono::duration<double, std::milli> elapsed = now - lastUpdateTime;
 
-    // Apply time scaling
-    worldTimeMillis += static_cast<uint64_t>(static_cast<float>(elapsed.count()) * timeScale);
+    // Apply time scaling, keep the sub-millisecond remainder so fast update loops still advance the clock
+    pendingMillis += elapsed.count() * static_cast<double>(timeScale);
+    uint64_t wholeMillis = static_cast<uint64_t>(pendingMillis);
+    worldTimeMillis += wholeMillis;
+    pendingMillis -= static_cast<double>(wholeMillis);
     lastUpdateTime = now;
 }
 
@@ -18,6 +32,21 @@ void WorldClock::Resume()
     lastUpdateTime = std::chrono::steady_clock::now();
 }
 
+void WorldClock::Reset(uint64_t timeMillis)
+{
+    worldTimeMillis = timeMillis;
+    pendingMillis = 0.0;
+    lastUpdateTime = std::chrono::steady_clock::now();
+}
+
+void WorldClock::SetMode(EClockMode inMode)
+{
+    // restart real time tracking so switching back doesn't apply the time spent in fixed step mode
+    mode = inMode;
+    pendingMillis = 0.0;
+    lastUpdateTime = std::chrono::steady_clock::now();
+}
+
 // SAVE & LOAD TBD
 void WorldClock::SaveToFile(const std::string& filename) const
 {
@@ -30,11 +59,12 @@ void WorldClock::LoadFromFile(const std::string& filename)
 
 bool WorldClock::CheckUpdateDelay(const uint64_t& interval, uint64_t& lastUpdateTimeRef)
 {
-    if (static_cast<int>(worldTimeMillis) - lastUpdateTimeRef < interval)
+    // compare in uint64 so long runs don't overflow, and a ref ahead of the clock (after Reset) isn't treated as passed
+    if (worldTimeMillis < lastUpdateTimeRef || worldTimeMillis - lastUpdateTimeRef < interval)
     {
         return false;
     }
-    lastUpdateTimeRef = static_cast<int>(worldTimeMillis);
+    lastUpdateTimeRef = worldTimeMillis;
     return true;
 }
 
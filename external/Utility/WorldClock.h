@@ -4,6 +4,14 @@
 #include <string>
 #include "Utility.h"
 
+// How the world clock advances on Update()
+enum class EClockMode
+{
+    RealTime,   // advance by real elapsed time scaled by timeScale
+    FixedStep,  // advance by exactly fixedStepMillis per Update(), or by explicit Advance/AdvanceTo calls. Reproducible
+    EventDriven,// Update() doesn't move time, the driver jumps straight to the next scheduled event with AdvanceTo. Reproducible
+};
+
 /*
  * The clock that simulates time in the virtual world that our systems live in. Other than user control panel & info
  * display data. Every entity shares the singleton global clock that can be sped up or down
@@ -21,10 +29,19 @@ public:
     void SetSpeed(float speedMultiplier) { timeScale = speedMultiplier; }
     void Pause() { bIsPaused = true; }
     void Resume();
+    void Reset(uint64_t timeMillis = 0);
+
+    // Virtual time control, decoupled from real time
+    void SetMode(EClockMode inMode);
+    void SetFixedStep(uint64_t stepMillis) { fixedStepMillis = stepMillis; }
+    void Advance(uint64_t deltaMillis) { worldTimeMillis += deltaMillis; }
+    void AdvanceTo(uint64_t targetMillis) { if (targetMillis > worldTimeMillis) worldTimeMillis = targetMillis; } // never goes back in time
 
     uint64_t GetGameTimeMillis() const { return worldTimeMillis; }
     float GetSpeed() const { return timeScale; }
     bool GetIsPaused() const { return bIsPaused; }
+    EClockMode GetMode() const { return mode; }
+    uint64_t GetFixedStep() const { return fixedStepMillis; }
     void SaveToFile(const std::string& filename) const;
     void LoadFromFile(const std::string& filename);
 
@@ -35,6 +52,9 @@ private:
     uint64_t worldTimeMillis = 0;
     float timeScale = 1.0f;
     bool bIsPaused = false;
+    EClockMode mode = EClockMode::RealTime;
+    uint64_t fixedStepMillis = 16;
+    double pendingMillis = 0.0; // scaled time not yet applied to worldTimeMillis
 
     std::chrono::steady_clock::time_point lastUpdateTime;
 };
@@ -55,11 +75,18 @@ public:
     static constexpr uint64_t MILLISENCONDS_PER_MONTH = MILLISENCONDS_PER_DAY * DAY_PER_MONTH;
     static constexpr uint64_t MILLISENCONDS_PER_YEAR = MILLISENCONDS_PER_MONTH * MONTH_PER_YEAR;
 
-    static int GetYear(uint64_t startTimeMillis = 0) { return static_cast<int>(1 + GetWorldTimeMillis(startTimeMillis) / MILLISENCONDS_PER_YEAR); }
-    static int GetMonth(uint64_t startTimeMillis = 0) { return static_cast<int>(1 + (GetWorldTimeMillis(startTimeMillis) % MILLISENCONDS_PER_YEAR) / MILLISENCONDS_PER_MONTH); }
-    static int GetDay(uint64_t startTimeMillis = 0) { return static_cast<int>(1 + (GetWorldTimeMillis(startTimeMillis) % MILLISENCONDS_PER_MONTH) / MILLISENCONDS_PER_DAY); }
-    static int GetHour(uint64_t startTimeMillis = 0) { return static_cast<int>((GetWorldTimeMillis(startTimeMillis) % MILLISENCONDS_PER_DAY) / MILLISENCONDS_PER_HOUR); }
-    static int GetMinute(uint64_t startTimeMillis = 0) { return static_cast<int>((GetWorldTimeMillis(startTimeMillis) % MILLISENCONDS_PER_HOUR) / MILLISENCONDS_PER_MINUTE); }
+    static int GetYear(uint64_t startTimeMillis = 0) { return GetYearAt(GetWorldTimeMillis(startTimeMillis)); }
+    static int GetMonth(uint64_t startTimeMillis = 0) { return GetMonthAt(GetWorldTimeMillis(startTimeMillis)); }
+    static int GetDay(uint64_t startTimeMillis = 0) { return GetDayAt(GetWorldTimeMillis(startTimeMillis)); }
+    static int GetHour(uint64_t startTimeMillis = 0) { return GetHourAt(GetWorldTimeMillis(startTimeMillis)); }
+    static int GetMinute(uint64_t startTimeMillis = 0) { return GetMinuteAt(GetWorldTimeMillis(startTimeMillis)); }
+
+    // calendar of a given world time, doesn't read the clock so any thread can use it
+    static int GetYearAt(uint64_t timeMillis) { return static_cast<int>(1 + timeMillis / MILLISENCONDS_PER_YEAR); }
+    static int GetMonthAt(uint64_t timeMillis) { return static_cast<int>(1 + (timeMillis % MILLISENCONDS_PER_YEAR) / MILLISENCONDS_PER_MONTH); }
+    static int GetDayAt(uint64_t timeMillis) { return static_cast<int>(1 + (timeMillis % MILLISENCONDS_PER_MONTH) / MILLISENCONDS_PER_DAY); }
+    static int GetHourAt(uint64_t timeMillis) { return static_cast<int>((timeMillis % MILLISENCONDS_PER_DAY) / MILLISENCONDS_PER_HOUR); }
+    static int GetMinuteAt(uint64_t timeMillis) { return static_cast<int>((timeMillis % MILLISENCONDS_PER_HOUR) / MILLISENCONDS_PER_MINUTE); }
 
     static uint64_t GetWorldTimeMillis(uint64_t startTimeMillis = 0){ return WorldClock::GetInstance().GetGameTimeMillis() - startTimeMillis; }
 
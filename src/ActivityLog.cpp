@@ -0,0 +1,31 @@
+#include "ActivityLog.h"
+
+#include <cstdio>
+
+#include "MM_Elements.h"
+#include "WorldClock.h"
+
+std::string FActivityLog::Format(const FActivityRecord& record)
+{
+    const EPlayerState state = static_cast<EPlayerState>(record.arg);
+    char text[128];
+    switch (record.code)
+    {
+    case EActivityCode::SetState:               (void)snprintf(text, sizeof(text), "set to state: %s", ToString(state).c_str()); break;
+    case EActivityCode::FailedSameState:        (void)snprintf(text, sizeof(text), "failed: tried setting same state: %s", ToString(state).c_str()); break;
+    case EActivityCode::FailedInGameToOffline:  (void)snprintf(text, sizeof(text), "failed: tried setting from InGame to Offline"); break;
+    case EActivityCode::FailedOfflineToInQueue: (void)snprintf(text, sizeof(text), "failed: tried setting from Offline to InQueue"); break;
+    case EActivityCode::FailedOfflineToInGame:  (void)snprintf(text, sizeof(text), "failed: tried setting from Offline to InGame"); break;
+    case EActivityCode::FailedToJoinQueue:      (void)snprintf(text, sizeof(text), "failed to join queue"); break;
+    case EActivityCode::ScheduledState:         (void)snprintf(text, sizeof(text), "scheduled to %s", ToString(state).c_str()); break;
+    case EActivityCode::JoinedMatch:            (void)snprintf(text, sizeof(text), "joined match: %d", record.arg); break;
+    case EActivityCode::MatchEnded:             (void)snprintf(text, sizeof(text), "match %d ended", record.arg); break;
+    default:                                    (void)snprintf(text, sizeof(text), "unknown activity %d", static_cast<int>(record.code)); break;
+    }
+
+    const int hour = static_cast<int>((record.time % WorldTime::MILLISENCONDS_PER_DAY) / WorldTime::MILLISENCONDS_PER_HOUR);
+    const int minute = static_cast<int>((record.time % WorldTime::MILLISENCONDS_PER_HOUR) / WorldTime::MILLISENCONDS_PER_MINUTE);
+    char line[160];
+    (void)snprintf(line, sizeof(line), "[%02d:%02d] %s", hour, minute, text);
+    return line;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Compile the activity log out entirely with -DMM_ENABLE_ACTIVITY_LOG=0
+#ifndef MM_ENABLE_ACTIVITY_LOG
+#define MM_ENABLE_ACTIVITY_LOG 1
+#endif
+
+// What a player did, the text is only built when the log is displayed
+enum class EActivityCode : uint8_t
+{
+    SetState,               // arg: new EPlayerState
+    FailedSameState,        // arg: requested EPlayerState
+    FailedInGameToOffline,
+    FailedOfflineToInQueue,
+    FailedOfflineToInGame,
+    FailedToJoinQueue,
+    ScheduledState,         // arg: scheduled EPlayerState
+    JoinedMatch,            // arg: match id
+    MatchEnded,             // arg: match id
+};
+
+struct FActivityRecord
+{
+    uint64_t time = 0; // world millis
+    int32_t arg = 0;
+    EActivityCode code = EActivityCode::SetState;
+};
+
+// Fixed capacity ring of binary activity records, the oldest record is overwritten once full.
+// Storage starts at a few records and doubles up to CAPACITY, so players that never or rarely log cost little.
+class FActivityLog
+{
+public:
+    static constexpr size_t CAPACITY = 64;
+    static constexpr size_t INITIAL_CAPACITY = 4;
+
+    // runtime switch shared by every player, records added while disabled are dropped.
+    // Worker threads read it while logging, so a switch only needs to be seen eventually
+    static void SetEnabled(bool bEnabled) { bIsEnabled.store(bEnabled, std::memory_order_relaxed); }
+    static bool IsEnabled() { return MM_ENABLE_ACTIVITY_LOG && bIsEnabled.load(std::memory_order_relaxed); }
+
+    void Add(uint64_t time, EActivityCode code, int arg = 0)
+    {
+#if MM_ENABLE_ACTIVITY_LOG
+        if (!bIsEnabled.load(std::memory_order_relaxed)) return;
+
+        if (records.size() < CAPACITY)
+        {
+            if (records.size() == records.capacity())
+            {
+                records.reserve(records.empty() ? INITIAL_CAPACITY : (std::min)(records.size() * 2, CAPACITY));
+            }
+            records.push_back({time, arg, code});
+            return;
+        }
+        records[head] = {time, arg, code};
+        head = (head + 1) % CAPACITY;
+#else
+        (void)time; (void)code; (void)arg;
+#endif
+    }
+
+    size_t Size() const { return records.size(); }
+    bool IsEmpty() const { return records.empty(); }
+
+    // records in insertion order, 0 is the oldest one still kept
+    const FActivityRecord& operator[](size_t index) const { return records[(head + index) % records.size()]; }
+
+    // "[HH:MM] text" for display
+    static std::string Format(const FActivityRecord& record);
+
+private:
+    static inline std::atomic<bool> bIsEnabled{true};
+
+    std::vector<FActivityRecord> records;
+    size_t head = 0; // oldest record once the ring is full
+};
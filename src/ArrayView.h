@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Non owning view of a contiguous range, for read APIs that hand out parts of internal arrays without copying.
+// Valid until the viewed container changes size or is destroyed
+template <typename T>
+class TArrayView
+{
+public:
+    TArrayView() = default;
+    TArrayView(const T* inData, size_t inSize) : data(inData), count(inSize) {}
+    TArrayView(const std::vector<T>& container) : data(container.data()), count(container.size()) {}
+
+    const T* begin() const { return data; }
+    const T* end() const { return data + count; }
+    const T& operator[](size_t index) const { return data[index]; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+private:
+    const T* data = nullptr;
+    size_t count = 0;
+};
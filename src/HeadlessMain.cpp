@@ -0,0 +1,321 @@
+// Headless runner for the MatchMaking simulation
+// Drives MatchMakingSystem without SDL/ImGui so the simulation is not capped by the display refresh rate.
+// Intended for long capacity studies on machines without a display.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Logger.h"
+#include "MatchMakingSystem.h"
+#include "RandomGenerator.h"
+#include "ShardCoordinator.h"
+#include "WorldClock.h"
+
+// All settings the headless run can take from the command line
+struct FHeadlessSetting
+{
+    int population = 10000;
+    int days = 1;
+    EClockMode clockMode = EClockMode::FixedStep; // fixed step runs are reproducible for a given seed
+    uint64_t fixedStepMillis = 16;
+    float timeScale = 1000.0f; // world millis advanced per real millis, real time clock only
+    uint64_t seed = 0;
+    bool bHasSeed = false;
+    bool bActivityLog = false; // nobody reads the per player log without the GUI
+    bool bTaskTiming = false;
+    EMatchMakeAlgorithm algorithm = LIFO;
+    FMatchSetting matchSetting;
+    FWorldSetting worldSetting;
+    FShardSetting shardSetting;
+};
+
+static void PrintUsage()
+{
+    std::cout <<
+        "Usage: MatchMakerHeadless [options]\n"
+        "  --population <n>           players to create (default 10000)\n"
+        "  --days <n>                 simulated days to run (default 1)\n"
+        "  --clock <mode>             fixed | event | realtime (default fixed)\n"
+        "                             event jumps straight to the next scheduled event, skipping idle time\n"
+        "  --step <ms>                world millis per tick in fixed mode (default 16)\n"
+        "  --speed <x>                world time scale in realtime mode (default 1000)\n"
+        "  --seed <n>                 RNG seed (default: time based)\n"
+        "  --algorithm <name>         LIFO | FIFO | SkillBased | TraitGrouping\n"
+        "  --teams <n>                FMatchSetting::numTeams\n"
+        "  --team-size <n>            FMatchSetting::teamSize\n"
+        "  --match-duration <ms>      FMatchSetting::matchDuration\n"
+        "  --draft-interval <ms>      FMatchSetting::draftInterval\n"
+        "  --pool-check-interval <ms> FMatchSetting::draftedPoolCheckInterval\n"
+        "  --matches-per-cycle <n>    FMatchSetting::matchesPerCycle\n"
+        "  --max-skill-gap <n>        FMatchSetting::maxSkillGap\n"
+        "  --batch <n>                FWorldSetting::avgPlayerPerBatch\n"
+        "  --event-budget <us>        FWorldSetting::eventBudgetMicros, 0 = process every due event (default)\n"
+        "  --threads <n>              FWorldSetting::workerThreads of the job system, results don't change (default 1)\n"
+        "  --task-timing <on|off>     time every update phase and parallel loop, printed with the summary (default off)\n"
+        "  --pipeline <on|off>        FWorldSetting::bPipelinedDraft, draft and start matches as overlapping stages (default off)\n"
+        "  --shards <n>               FShardSetting::numShards, regions matched separately (default 1)\n"
+        "  --region-weights <a,b,..>  FShardSetting::regionWeights, share of the players per shard (default even)\n"
+        "  --overflow-wait <ms>       FShardSetting::overflowWaitMillis, queue time before a player moves shard (0 = off)\n"
+        "  --activity-log <on|off>    keep the per player activity log (default off)\n"
+        "  --archive-window <n>       FWorldSetting::matchArchiveWindow, completed matches kept in memory (0 = all)\n"
+        "  --archive-file <path>      FWorldSetting::matchArchiveFile, spill older completed matches to this file\n"
+        "  --help                     show this message\n";
+}
+
+static bool ParseAlgorithm(const std::string& name, EMatchMakeAlgorithm& outAlgorithm)
+{
+    if (name == "LIFO")          { outAlgorithm = LIFO; return true; }
+    if (name == "FIFO")          { outAlgorithm = FIFO; return true; }
+    if (name == "SkillBased")    { outAlgorithm = SkillBased; return true; }
+    if (name == "TraitGrouping") { outAlgorithm = TraitGrouping; return true; }
+    return false;
+}
+
+static const char* ToString(EMatchMakeAlgorithm algorithm)
+{
+    switch (algorithm)
+    {
+    case LIFO:          return "LIFO";
+    case FIFO:          return "FIFO";
+    case SkillBased:    return "SkillBased";
+    case TraitGrouping: return "TraitGrouping";
+    }
+    return "Unknown";
+}
+
+// returns false if the command line is invalid or help was requested
+static bool ParseArguments(int argc, char** argv, FHeadlessSetting& setting)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h")
+        {
+            return false;
+        }
+
+        if (i + 1 >= argc)
+        {
+            std::cout << "Missing value for " << arg << "\n";
+            return false;
+        }
+        const char* value = argv[++i];
+
+        if      (arg == "--population")          { setting.population = std::atoi(value); }
+        else if (arg == "--days")                { setting.days = std::atoi(value); }
+        else if (arg == "--step")                { setting.fixedStepMillis = std::strtoull(value, nullptr, 10); }
+        else if (arg == "--speed")               { setting.timeScale = static_cast<float>(std::atof(value)); }
+        else if (arg == "--seed")                { setting.seed = std::strtoull(value, nullptr, 10); setting.bHasSeed = true; }
+        else if (arg == "--teams")               { setting.matchSetting.numTeams = std::atoi(value); }
+        else if (arg == "--team-size")           { setting.matchSetting.teamSize = std::atoi(value); }
+        else if (arg == "--match-duration")      { setting.matchSetting.matchDuration = std::atoi(value); }
+        else if (arg == "--draft-interval")      { setting.matchSetting.draftInterval = std::atoi(value); }
+        else if (arg == "--pool-check-interval") { setting.matchSetting.draftedPoolCheckInterval = std::atoi(value); }
+        else if (arg == "--matches-per-cycle")   { setting.matchSetting.matchesPerCycle = std::atoi(value); }
+        else if (arg == "--max-skill-gap")       { setting.matchSetting.maxSkillGap = std::atoi(value); }
+        else if (arg == "--batch")               { setting.worldSetting.avgPlayerPerBatch = std::atoi(value); }
+        else if (arg == "--event-budget")        { setting.worldSetting.eventBudgetMicros = std::atoi(value); }
+        else if (arg == "--threads")             { setting.worldSetting.workerThreads = std::atoi(value); }
+        else if (arg == "--shards")              { setting.shardSetting.numShards = std::atoi(value); }
+        else if (arg == "--overflow-wait")       { setting.shardSetting.overflowWaitMillis = std::strtoull(value, nullptr, 10); }
+        else if (arg == "--region-weights")
+        {
+            setting.shardSetting.regionWeights.clear();
+            for (const char* weight = value; weight != nullptr; weight = std::strchr(weight, ','))
+            {
+                if (*weight == ',') ++weight;
+                setting.shardSetting.regionWeights.push_back(static_cast<float>(std::atof(weight)));
+            }
+        }
+        else if (arg == "--activity-log")        { setting.bActivityLog = std::string(value) == "on"; }
+        else if (arg == "--task-timing")         { setting.bTaskTiming = std::string(value) == "on"; }
+        else if (arg == "--pipeline")            { setting.worldSetting.bPipelinedDraft = std::string(value) == "on"; }
+        else if (arg == "--archive-window")      { setting.worldSetting.matchArchiveWindow = std::atoi(value); }
+        else if (arg == "--archive-file")        { setting.worldSetting.matchArchiveFile = value; }
+        else if (arg == "--clock")
+        {
+            if (std::string(value) == "fixed")         { setting.clockMode = EClockMode::FixedStep; }
+            else if (std::string(value) == "event")    { setting.clockMode = EClockMode::EventDriven; }
+            else if (std::string(value) == "realtime") { setting.clockMode = EClockMode::RealTime; }
+            else
+            {
+                std::cout << "Unknown clock mode: " << value << "\n";
+                return false;
+            }
+        }
+        else if (arg == "--algorithm")
+        {
+            if (!ParseAlgorithm(value, setting.algorithm))
+            {
+                std::cout << "Unknown algorithm: " << value << "\n";
+                return false;
+            }
+        }
+        else
+        {
+            std::cout << "Unknown option: " << arg << "\n";
+            return false;
+        }
+    }
+
+    setting.matchSetting.totalPlayer = setting.matchSetting.numTeams * setting.matchSetting.teamSize;
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    FHeadlessSetting setting;
+    if (!ParseArguments(argc, argv, setting))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    uint64_t seed = setting.bHasSeed ? setting.seed : static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    SeedRandomGenerator(seed);
+    FActivityLog::SetEnabled(setting.bActivityLog);
+
+    FShardCoordinator* MMSim = new FShardCoordinator(setting.shardSetting, setting.algorithm, seed);
+    MMSim->SetMatchSetting(setting.matchSetting);
+    MMSim->SetWorldSetting(setting.worldSetting);
+    MMSim->AddToPlayerCreationQueue(setting.population);
+    MMSim->SetTaskTimingEnabled(setting.bTaskTiming);
+
+    GetWorldClock().SetMode(setting.clockMode);
+    GetWorldClock().SetFixedStep(setting.fixedStepMillis);
+    GetWorldClock().SetSpeed(setting.timeScale);
+    GetWorldClock().Resume();
+
+    const uint64_t endTime = WorldTime::GetWorldTimeMillis() + static_cast<uint64_t>(setting.days) * WorldTime::MILLISENCONDS_PER_DAY;
+
+    FValueHistogram tickDurations(0.1, 1000000); // microseconds, 0.1us buckets up to 100ms
+    FSystemCounters counters;
+    uint64_t ticks = 0;
+    int lastReportedDay = WorldTime::GetDay();
+
+    auto runStartTime = std::chrono::steady_clock::now();
+    while (WorldTime::GetWorldTimeMillis() < endTime)
+    {
+        if (setting.clockMode == EClockMode::EventDriven)
+        {
+            GetWorldClock().AdvanceTo((std::min)(MMSim->GetNextEventTime(), endTime));
+        }
+        else
+        {
+            GetWorldClock().Update();
+        }
+
+        auto tickStartTime = std::chrono::steady_clock::now();
+        MMSim->Update();
+        auto tickEndTime = std::chrono::steady_clock::now();
+
+        tickDurations.Add(std::chrono::duration<double, std::micro>(tickEndTime - tickStartTime).count());
+        ++ticks;
+
+        if (WorldTime::GetDay() != lastReportedDay)
+        {
+            lastReportedDay = WorldTime::GetDay();
+            uint64_t matchesStarted = 0;
+            for (int i = 0; i < MMSim->GetNumShards(); ++i)
+            {
+                matchesStarted += MMSim->GetShard(i).GetCounters().matchesStarted;
+            }
+            std::cout << "Day " << lastReportedDay << " reached, players: " << MMSim->GetNumActivePlayers()
+                      << ", matches: " << matchesStarted << "\n";
+        }
+    }
+    auto runEndTime = std::chrono::steady_clock::now();
+
+    double wallSeconds = std::chrono::duration<double>(runEndTime - runStartTime).count();
+    MMSim->GetCounters(counters);
+    FSystemHistograms histograms;
+    MMSim->GetHistograms(histograms);
+    std::pair<int, int> queueTimePair = WorldTime::conv_DayTimePair(static_cast<uint64_t>(MMSim->GetAvgQueueTime()));
+
+    std::cout << "\n===== Headless run summary =====\n";
+    std::cout << "Seed: " << seed << "\n";
+    std::cout << "Clock: " << (setting.clockMode == EClockMode::FixedStep ? "fixed step " + std::to_string(setting.fixedStepMillis) + "ms"
+                              : setting.clockMode == EClockMode::EventDriven ? std::string("event driven")
+                              : "real time x" + std::to_string(setting.timeScale)) << "\n";
+    std::cout << "Algorithm: " << ToString(setting.algorithm) << "\n";
+    std::cout << "Match: " << setting.matchSetting.numTeams << " teams x " << setting.matchSetting.teamSize << " players\n";
+    std::cout << "Simulated days: " << setting.days << " (" << WorldTime::GetWorldTimeMillis() << " world ms)\n";
+    std::cout << "Players: " << MMSim->GetNumActivePlayers() << " / " << setting.population << "\n";
+    std::cout << "Matches started: " << counters.matchesStarted << ", completed: " << counters.matchesCompleted << "\n";
+    std::cout << "State events processed: " << counters.stateEventsProcessed << "\n";
+    std::cout << "Event lateness avg: " << histograms.stateEventLateness.GetAverage() << " ms"
+              << ", p99: " << histograms.stateEventLateness.GetPercentile(0.99) << " ms"
+              << ", max: " << histograms.stateEventLateness.max << " ms\n";
+    if (setting.worldSetting.bPipelinedDraft)
+    {
+        std::cout << "Ready team wait avg: " << histograms.readyTeamWait.GetAverage() << " ms"
+                  << ", p99: " << histograms.readyTeamWait.GetPercentile(0.99) << " ms"
+                  << ", max: " << histograms.readyTeamWait.max << " ms\n";
+    }
+    std::cout << "Event backlog peak: " << counters.peakStateEventBacklog
+              << " (budget " << (setting.worldSetting.eventBudgetMicros > 0 ? std::to_string(setting.worldSetting.eventBudgetMicros) + " us" : std::string("unlimited"))
+              << ", exhausted in " << counters.budgetExhaustedUpdates << " updates)\n";
+    size_t archived = 0, inMemory = 0, spilled = 0, discarded = 0;
+    for (int i = 0; i < MMSim->GetNumShards(); ++i)
+    {
+        const FMatchArchive& archive = MMSim->GetShard(i).GetMatchArchive();
+        archived += archive.Size();
+        inMemory += archive.GetInMemoryCount();
+        spilled += archive.GetSpilledCount();
+        discarded += archive.GetDiscardedCount();
+    }
+    std::cout << "Match archive: " << archived << " matches, " << inMemory << " in memory, "
+              << spilled << " spilled, " << discarded << " discarded\n";
+    std::cout << "Average queue time: " << queueTimePair.first << ":" << queueTimePair.second
+              << " (" << MMSim->GetAvgQueueTime() << " ms), game time: " << MMSim->GetAvgGameTime() << " ms"
+              << ", online time per player: " << MMSim->GetAvgOnlineTime() << " ms\n";
+    std::cout << "Queue time by hour of day (ms):";
+    for (int hour = 0; hour < FPopulationStats::HOURS_PER_DAY; ++hour)
+    {
+        std::cout << " " << static_cast<int>(MMSim->GetAvgTimeInStateByHour(EPlayerState::InQueue, hour));
+    }
+    std::cout << "\n";
+    if (MMSim->GetNumShards() > 1)
+    {
+        for (int i = 0; i < MMSim->GetNumShards(); ++i)
+        {
+            const MatchMakingSystem& shard = MMSim->GetShard(i);
+            const FShardCounters& shardCounters = MMSim->GetShardCounters(i);
+            std::cout << "Shard " << i << ": players " << static_cast<int>(shard.GetAllPlayers().size()) - shard.GetNumPlayerOfState(EPlayerState::None)
+                      << ", queued " << shard.GetNumPlayerOfState(EPlayerState::InQueue)
+                      << ", matches " << shard.GetCounters().matchesCompleted
+                      << ", avg queue " << shard.GetAvgQueueTime() << " ms"
+                      << ", overflow out " << shardCounters.playersSentOut << " in " << shardCounters.playersReceived << "\n";
+        }
+    }
+    if (setting.bTaskTiming)
+    {
+        // wall time includes the nested tasks, parallelism is the busy time of the task's own chunks over its wall time
+        std::cout << "Task timing (" << MMSim->GetJobSystem().GetNumThreads() << " threads):\n";
+        for (const FTaskTiming& timing : MMSim->GetJobSystem().GetTimings())
+        {
+            char line[256];
+            snprintf(line, sizeof(line), "  %-26s runs %9llu, chunks %9llu, total %10.1f ms, avg %8.2f us, max %9.1f us, parallelism %.2f\n",
+                timing.name.c_str(), static_cast<unsigned long long>(timing.runs), static_cast<unsigned long long>(timing.chunks),
+                timing.wallMicros / 1000.0, timing.GetAvgWallMicros(), timing.maxWallMicros, timing.GetParallelism());
+            std::cout << line;
+        }
+    }
+    std::cout << "Wall time: " << wallSeconds << " s\n";
+    std::cout << "Ticks: " << ticks << " (" << (wallSeconds > 0.0 ? static_cast<double>(ticks) / wallSeconds : 0.0) << " ticks/s)\n";
+    std::cout << "Events/s: " << (wallSeconds > 0.0 ? static_cast<double>(counters.stateEventsProcessed) / wallSeconds : 0.0) << "\n";
+    std::cout << "Matches/s: " << (wallSeconds > 0.0 ? static_cast<double>(counters.matchesCompleted) / wallSeconds : 0.0) << "\n";
+    std::cout << "Update() avg: " << tickDurations.GetAverage() << " us"
+              << ", p50: " << tickDurations.GetPercentile(0.50) << " us"
+              << ", p99: " << tickDurations.GetPercentile(0.99) << " us"
+              << ", max: " << tickDurations.max << " us\n";
+
+    delete MMSim;
+    return 0;
+}
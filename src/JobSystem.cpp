@@ -0,0 +1,270 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+    // queue of the worker thread, threads outside of the system use queue 0
+    thread_local const FJobSystem* currentSystem = nullptr;
+    thread_local int currentQueue = 0;
+
+    // time spent running other jobs while the current job waited, taken out of its busy time
+    thread_local int64_t nestedNanos = 0;
+
+    int64_t NowNanos()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+FJobGraph::FTaskId FJobGraph::AddTask(const char* name, std::function<void()> body, const std::vector<FTaskId>& dependencies)
+{
+    const FTaskId id = static_cast<FTaskId>(tasks.size());
+    std::unique_ptr<FJobTask> task = std::make_unique<FJobTask>();
+    task->name = name;
+    task->ownedBody = [inBody = std::move(body)](size_t, size_t) { inBody(); };
+    task->body = &task->ownedBody;
+    for (FTaskId dependency : dependencies)
+    {
+        if (dependency < 0 || dependency >= id) continue; // not added yet, would never finish
+        tasks[dependency]->dependents.push_back(task.get());
+        ++task->numDependencies;
+    }
+    tasks.push_back(std::move(task));
+    return id;
+}
+
+FJobSystem::FJobSystem(int numThreads)
+{
+    numThreads = (std::max)(numThreads, 1);
+    queues = std::make_unique<FWorkQueue[]>(numThreads);
+    for (int i = 1; i < numThreads; ++i)
+    {
+        workers.emplace_back(&FJobSystem::WorkerLoop, this, i);
+    }
+}
+
+FJobSystem::~FJobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        bStopping = true;
+    }
+    wakeCondition.notify_all();
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void FJobSystem::Run(FJobGraph& graph)
+{
+    if (graph.tasks.empty()) return;
+
+    std::atomic<size_t> tasksLeft{graph.tasks.size()};
+    for (std::unique_ptr<FJobTask>& task : graph.tasks)
+    {
+        task->tasksLeft = &tasksLeft;
+        task->dependenciesLeft = task->numDependencies;
+    }
+    for (std::unique_ptr<FJobTask>& task : graph.tasks)
+    {
+        if (task->numDependencies == 0)
+        {
+            Release(*task);
+        }
+    }
+    WaitFor(tasksLeft);
+}
+
+void FJobSystem::ParallelFor(const char* name, size_t count, size_t minChunk, const std::function<void(size_t, size_t)>& body)
+{
+    if (count == 0) return;
+
+    // a few chunks per thread so a slow chunk doesn't hold the others back
+    const size_t numThreads = static_cast<size_t>(GetNumThreads());
+    const size_t targetChunk = (count + numThreads * 4 - 1) / (numThreads * 4);
+
+    FJobTask task;
+    task.name = name;
+    task.body = &body;
+    task.count = count;
+    task.chunkSize = workers.empty() ? count : (std::max)(targetChunk, (std::max)(minChunk, static_cast<size_t>(1)));
+
+    std::atomic<size_t> tasksLeft{1};
+    task.tasksLeft = &tasksLeft;
+    Release(task);
+    WaitFor(tasksLeft);
+}
+
+void FJobSystem::Release(FJobTask& task)
+{
+    const size_t numChunks = (task.count + task.chunkSize - 1) / task.chunkSize;
+    task.chunksLeft = numChunks;
+    task.startNanos = 0;
+    task.busyNanos = 0;
+
+    // nothing to share the work with, run it right away
+    if (workers.empty())
+    {
+        for (size_t begin = 0; begin < task.count; begin += task.chunkSize)
+        {
+            Execute({&task, begin, (std::min)(begin + task.chunkSize, task.count)});
+        }
+        return;
+    }
+
+    // pushed last chunk first, the owner pops from the back and works through the range in order
+    FWorkQueue& queue = queues[GetQueueIndex()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        for (size_t chunk = numChunks; chunk-- > 0;)
+        {
+            const size_t begin = chunk * task.chunkSize;
+            queue.jobs.push_back({&task, begin, (std::min)(begin + task.chunkSize, task.count)});
+        }
+    }
+    queuedJobs.fetch_add(numChunks);
+
+    // taking the lock orders the push before a worker's check, so none goes to sleep on it
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wakeCondition.notify_all();
+}
+
+void FJobSystem::Execute(const FJob& job)
+{
+    FJobTask& task = *job.task;
+    if (!bTimingEnabled.load(std::memory_order_relaxed))
+    {
+        (*task.body)(job.begin, job.end);
+        if (task.chunksLeft.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            Finish(task);
+        }
+        return;
+    }
+
+    const int64_t start = NowNanos();
+    int64_t firstStart = task.startNanos.load(std::memory_order_relaxed);
+    while ((firstStart == 0 || start < firstStart) && !task.startNanos.compare_exchange_weak(firstStart, start, std::memory_order_relaxed)) {}
+
+    const int64_t outerNestedNanos = nestedNanos;
+    nestedNanos = 0;
+    (*task.body)(job.begin, job.end);
+    const int64_t elapsed = NowNanos() - start;
+    task.busyNanos.fetch_add(elapsed - nestedNanos, std::memory_order_relaxed);
+    nestedNanos = outerNestedNanos + elapsed;
+
+    if (task.chunksLeft.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        Finish(task);
+    }
+}
+
+void FJobSystem::Finish(FJobTask& task)
+{
+    if (task.startNanos.load(std::memory_order_relaxed) != 0) // timed
+    {
+        RecordTiming(task);
+    }
+
+    for (FJobTask* dependent : task.dependents)
+    {
+        if (dependent->dependenciesLeft.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            Release(*dependent);
+        }
+    }
+
+    // the waiter may return and free the task right after this
+    task.tasksLeft->fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void FJobSystem::RecordTiming(const FJobTask& task)
+{
+    const double wallMicros = static_cast<double>(NowNanos() - task.startNanos.load(std::memory_order_relaxed)) / 1000.0;
+    {
+        std::lock_guard<std::mutex> lock(timingMutex);
+        auto timing = std::find_if(timings.begin(), timings.end(), [&task](const FTaskTiming& entry) { return entry.name == task.name; });
+        if (timing == timings.end())
+        {
+            timings.push_back({task.name});
+            timing = timings.end() - 1;
+        }
+        ++timing->runs;
+        timing->chunks += (task.count + task.chunkSize - 1) / task.chunkSize;
+        timing->wallMicros += wallMicros;
+        timing->maxWallMicros = (std::max)(timing->maxWallMicros, wallMicros);
+        timing->busyMicros += static_cast<double>(task.busyNanos.load(std::memory_order_relaxed)) / 1000.0;
+    }
+}
+
+bool FJobSystem::TryRunJob()
+{
+    if (queuedJobs.load(std::memory_order_acquire) == 0) return false;
+
+    // own queue from the back first, then steal the oldest job of the others
+    const int numQueues = GetNumThreads();
+    const int ownQueue = GetQueueIndex();
+    for (int k = 0; k < numQueues; ++k)
+    {
+        FWorkQueue& queue = queues[(ownQueue + k) % numQueues];
+        std::unique_lock<std::mutex> lock(queue.mutex);
+        if (queue.jobs.empty()) continue;
+
+        const FJob job = k == 0 ? queue.jobs.back() : queue.jobs.front();
+        k == 0 ? queue.jobs.pop_back() : queue.jobs.pop_front();
+        lock.unlock();
+
+        queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+        Execute(job);
+        return true;
+    }
+    return false;
+}
+
+void FJobSystem::WaitFor(const std::atomic<size_t>& tasksLeft)
+{
+    // the remaining chunks may all be running elsewhere already, give their threads the core meanwhile
+    while (tasksLeft.load(std::memory_order_acquire) > 0)
+    {
+        if (!TryRunJob())
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+int FJobSystem::GetQueueIndex() const
+{
+    return currentSystem == this ? currentQueue : 0;
+}
+
+void FJobSystem::WorkerLoop(int index)
+{
+    currentSystem = this;
+    currentQueue = index;
+    while (true)
+    {
+        if (TryRunJob()) continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeCondition.wait(lock, [this] { return bStopping || queuedJobs.load(std::memory_order_acquire) > 0; });
+        if (bStopping) return;
+    }
+}
+
+std::vector<FTaskTiming> FJobSystem::GetTimings() const
+{
+    std::lock_guard<std::mutex> lock(timingMutex);
+    return timings;
+}
+
+void FJobSystem::ResetTimings()
+{
+    std::lock_guard<std::mutex> lock(timingMutex);
+    timings.clear();
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Time spent in one named task, summed over every run
+struct FTaskTiming
+{
+    std::string name;
+    uint64_t runs = 0;
+    uint64_t chunks = 0;
+    double wallMicros = 0.0; // first chunk start to last chunk end
+    double maxWallMicros = 0.0;
+    double busyMicros = 0.0; // summed over the chunks, nested tasks a chunk waited for aren't counted
+
+    double GetAvgWallMicros() const { return runs == 0 ? 0.0 : wallMicros / static_cast<double>(runs); }
+    // threads busy on average while the task ran, 1 for serial work
+    double GetParallelism() const { return wallMicros > 0.0 ? busyMicros / wallMicros : 0.0; }
+};
+
+// Schedulable unit, either a node of a FJobGraph or one ParallelFor. Split into chunks any thread may run
+struct FJobTask
+{
+    const char* name = "";
+    std::function<void(size_t, size_t)> ownedBody; // graph nodes keep their body here
+    const std::function<void(size_t, size_t)>* body = nullptr;
+    size_t count = 1;
+    size_t chunkSize = 1;
+    std::vector<FJobTask*> dependents;
+    int numDependencies = 0;
+
+    // state of the current run
+    std::atomic<int> dependenciesLeft{0};
+    std::atomic<size_t> chunksLeft{0};
+    std::atomic<size_t>* tasksLeft = nullptr; // of whoever waits for the task
+    std::atomic<int64_t> startNanos{0}; // of the chunk that started first
+    std::atomic<int64_t> busyNanos{0};
+};
+
+// Tasks with dependency edges, built once and run as often as needed by FJobSystem::Run, one run at a time
+class FJobGraph
+{
+public:
+    using FTaskId = int;
+
+    // dependencies have to be added before the task, so the ids are always in a valid serial order
+    FTaskId AddTask(const char* name, std::function<void()> body, const std::vector<FTaskId>& dependencies = {});
+    size_t Size() const { return tasks.size(); }
+
+private:
+    friend class FJobSystem;
+    std::vector<std::unique_ptr<FJobTask>> tasks;
+};
+
+/*
+ * Work stealing job system. Every thread has its own deque of chunks: it pushes and pops its own work at the back and
+ * steals from the front of the others when it runs dry. Threads waiting for a graph or a ParallelFor run chunks
+ * meanwhile, so tasks can submit nested work from inside a chunk without blocking a worker. The calling thread counts
+ * as one of the threads, with one thread everything runs inline in graph order.
+ */
+class FJobSystem
+{
+public:
+    explicit FJobSystem(int numThreads);
+    ~FJobSystem();
+
+    FJobSystem(const FJobSystem&) = delete;
+    FJobSystem& operator=(const FJobSystem&) = delete;
+
+    int GetNumThreads() const { return static_cast<int>(workers.size()) + 1; }
+
+    // returns once every task ran, each one after all of its dependencies
+    void Run(FJobGraph& graph);
+    // calls body(begin, end) on disjoint chunks covering [0, count), chunks hold at least minChunk indices
+    void ParallelFor(const char* name, size_t count, size_t minChunk, const std::function<void(size_t, size_t)>& body);
+
+    // off by default, two clock reads per chunk are a noticeable share of an idle update
+    void SetTimingEnabled(bool bEnabled) { bTimingEnabled = bEnabled; }
+    bool IsTimingEnabled() const { return bTimingEnabled; }
+    // one entry per task name, in the order the names first finished
+    std::vector<FTaskTiming> GetTimings() const;
+    void ResetTimings();
+
+private:
+    struct FJob
+    {
+        FJobTask* task;
+        size_t begin;
+        size_t end;
+    };
+
+    // padded so the threads don't share the cache line of their neighbour's lock
+    struct alignas(64) FWorkQueue
+    {
+        std::mutex mutex;
+        std::deque<FJob> jobs;
+    };
+
+    void WorkerLoop(int index);
+    void Release(FJobTask& task); // every dependency finished, queue its chunks
+    void Execute(const FJob& job);
+    void Finish(FJobTask& task);
+    void RecordTiming(const FJobTask& task);
+    bool TryRunJob();
+    void WaitFor(const std::atomic<size_t>& tasksLeft);
+    int GetQueueIndex() const;
+
+    std::vector<std::thread> workers;
+    std::unique_ptr<FWorkQueue[]> queues; // 0 belongs to the calling thread
+    std::atomic<size_t> queuedJobs{0};
+
+    std::mutex sleepMutex;
+    std::condition_variable wakeCondition;
+    bool bStopping = false;
+
+    std::atomic<bool> bTimingEnabled{false};
+    mutable std::mutex timingMutex;
+    std::vector<FTaskTiming> timings;
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ArrayView.h"
+
+// Bounded ranking of player ids by a stat value, keeps either the highest or the lowest values.
+// Entries are ordered in a std::set and found by id through a side map, so reporting a player is O(log k) and never
+// copies player data. Values are stored as float and equal values rank by ascending id, like FStatRankIndex, so the
+// top list shows the same order as the ranks.
+class FLeaderList
+{
+public:
+    explicit FLeaderList(bool bInKeepHighest = true) : entries(FEntryOrder{bInKeepHighest}) {}
+
+    // inserts or updates the player's value, then drops the worst entries beyond capacity
+    void Report(int playerId, double inValue, size_t capacity)
+    {
+        const float value = static_cast<float>(inValue);
+        auto it = values.find(playerId);
+        if (it != values.end())
+        {
+            if (it->second == value && entries.size() <= capacity) return;
+            entries.erase({it->second, playerId});
+            it->second = value;
+        }
+        else
+        {
+            // full and not better than the worst entry, nothing would change
+            if (capacity == 0) return;
+            if (entries.size() >= capacity && !entries.key_comp()({value, playerId}, GetWorst())) return;
+            values.emplace(playerId, value);
+        }
+        entries.insert({value, playerId});
+        bSortedIdsDirty = true;
+
+        while (entries.size() > capacity)
+        {
+            const FEntry worst = GetWorst();
+            values.erase(worst.second);
+            entries.erase(worst);
+        }
+    }
+
+    void Remove(int playerId)
+    {
+        auto it = values.find(playerId);
+        if (it == values.end()) return;
+        entries.erase({it->second, playerId});
+        values.erase(it);
+        bSortedIdsDirty = true;
+    }
+
+    size_t Size() const { return entries.size(); }
+    bool IsEmpty() const { return entries.empty(); }
+
+    // ids from the best entry to the worst, rebuilt only after the list changed. Valid until the next report
+    TArrayView<int> GetIds() const
+    {
+        if (bSortedIdsDirty)
+        {
+            sortedIds.clear();
+            for (const FEntry& entry : entries) { sortedIds.push_back(entry.second); }
+            bSortedIdsDirty = false;
+        }
+        return sortedIds;
+    }
+
+private:
+    using FEntry = std::pair<float, int>; // value, player id
+
+    // best entry first: highest or lowest value, then ascending id in both lists
+    struct FEntryOrder
+    {
+        bool bKeepHighest = true;
+        bool operator()(const FEntry& a, const FEntry& b) const
+        {
+            if (a.first != b.first) return bKeepHighest ? a.first > b.first : a.first < b.first;
+            return a.second < b.second;
+        }
+    };
+
+    std::set<FEntry, FEntryOrder> entries;
+    std::unordered_map<int, float> values; // player id -> value currently in entries
+    mutable std::vector<int> sortedIds;
+    mutable bool bSortedIdsDirty = false;
+
+    const FEntry& GetWorst() const { return *std::prev(entries.end()); }
+};
@@ -9,20 +9,19 @@
 
 #include "MatchMakingSystem.h"
 
-std::vector<VirtualPlayer::StateChangeCallback> VirtualPlayer::globalListeners;
+std::vector<std::pair<int, VirtualPlayer::StateChangeCallback>> VirtualPlayer::globalListeners;
+int VirtualPlayer::lastListenerHandle = 0;
 std::unordered_map<EPlayerState, std::vector<VirtualPlayer::StateChangeCallback>> VirtualPlayer::stateSpecificListeners;
 
-VirtualPlayer::VirtualPlayer(int inId, EPlayerTrait inTrait)
+void VirtualPlayer::Initialize(EPlayerTrait inTrait)
 {
-    id = inId;
-    traits = inTrait;
+    store->hot.traits[id] = inTrait;
     GenerateOnlineTimes();
 }
 
-VirtualPlayer::VirtualPlayer(int inId)
+void VirtualPlayer::Initialize()
 {
-    id = inId;
-    traits = GenerateRandomTraits();
+    store->hot.traits[id] = GenerateRandomTraits();
     ValidateTraits();
     ApplyTraitModifiers();
     GenerateOnlineTimes();
@@ -30,6 +29,35 @@ VirtualPlayer::VirtualPlayer(int inId)
     GetIsInOnlineTime() ? SetState(EPlayerState::Online) : SetState(EPlayerState::Offline);
 }
 
+void VirtualPlayer::Initialize(const FPlayerProfile& profile)
+{
+    FPlayerHotColumns& hot = store->hot;
+    hot.traits[id] = profile.traits;
+    hot.agr[id] = profile.stats[0];
+    hot.fle[id] = profile.stats[1];
+    hot.gri[id] = profile.stats[2];
+    hot.edr[id] = profile.stats[3];
+    hot.ins[id] = profile.stats[4];
+    hot.cre[id] = profile.stats[5];
+    hot.pre[id] = profile.stats[6];
+    store->cold[id].desiredOnlineTimes = profile.desiredOnlineTimes;
+    store->cold[id].homeShard = profile.homeShard;
+    store->cold[id].homeId = profile.homeId;
+
+    SetState(EPlayerState::Online);
+}
+
+FPlayerProfile VirtualPlayer::GetProfile() const
+{
+    FPlayerProfile profile;
+    profile.traits = GetTraits();
+    profile.stats = {GetAgr(), GetFle(), GetGri(), GetEdr(), GetIns(), GetCre(), GetPre()};
+    profile.desiredOnlineTimes = GetDesiredOnlineTimes();
+    profile.homeShard = store->cold[id].homeShard;
+    profile.homeId = store->cold[id].homeId;
+    return profile;
+}
+
 EPlayerTrait VirtualPlayer::GenerateRandomTraits()
 {
     EPlayerTrait newTraits = EPlayerTrait::None; // init
@@ -51,24 +79,25 @@ void VirtualPlayer::ValidateTraits()
 
 void VirtualPlayer::ApplyTraitModifiers()
 {
+    FPlayerHotColumns& hot = store->hot;
     for (const auto& [trait, traitInfo] : TraitDatabase)
     {
         if (HasTrait(trait))
         {
-            agr += traitInfo.agr;
-            fle += traitInfo.fle;
-            gri += traitInfo.gri;
-            edr += traitInfo.edr;
-            ins += traitInfo.ins;
-            cre += traitInfo.cre;
-            pre += traitInfo.pre;
+            hot.agr[id] += traitInfo.agr;
+            hot.fle[id] += traitInfo.fle;
+            hot.gri[id] += traitInfo.gri;
+            hot.edr[id] += traitInfo.edr;
+            hot.ins[id] += traitInfo.ins;
+            hot.cre[id] += traitInfo.cre;
+            hot.pre[id] += traitInfo.pre;
         }
     }
 }
 
-void VirtualPlayer::AddToActivityLog(std::string string)
+void VirtualPlayer::AddToActivityLog(EActivityCode code, int arg)
 {
-    activityLog.push_back(string);   
+    store->cold[id].activityLog.Add(WorldTime::GetWorldTimeMillis(), code, arg);
 }
 
 void VirtualPlayer::HandleConflictTrait_PickOne(const std::vector<EPlayerTrait>& conflictingTraits)
@@ -100,15 +129,18 @@ void VirtualPlayer::HandleConflictTrait_PickOne(const std::vector<EPlayerTrait>&
 
 void VirtualPlayer::RegisterMatchResult(int matchId, bool bIsWon)
 {
-    matchHistory.push_back(matchId);
+    FPlayerColdData& cold = store->cold[id];
+    cold.matchHistory.push_back(matchId);
     
     if (bIsWon)
     {
-        wonMatches.push_back(matchId);
+        cold.wonMatches.push_back(matchId);
+        ++store->hot.wonCount[id];
     }
     else
     {
-        lostMatches.push_back(matchId);
+        cold.lostMatches.push_back(matchId);
+        ++store->hot.lostCount[id];
     }
     
     UpdateWinRate();
@@ -116,95 +148,96 @@ void VirtualPlayer::RegisterMatchResult(int matchId, bool bIsWon)
 
 void VirtualPlayer::UpdateWinRate()
 {
-    winRate = matchHistory.empty() ? 0.0f : static_cast<float>(wonMatches.size()) / static_cast<float>(matchHistory.size());
+    const int played = GetTotalMatchesPlayed();
+    store->hot.winRate[id] = played == 0 ? 0.0f : static_cast<float>(store->hot.wonCount[id]) / static_cast<float>(played);
 }
 
 void VirtualPlayer::SetState(EPlayerState inState, bool forceUpdate)
 {
     if (!CanChangeToState(inState) && !forceUpdate) return;
     
+    FPlayerHotColumns& hot = store->hot;
     if (inState == EPlayerState::Online)
     {
-        currentIdleTime = RandomInt64WithAnchor(4000, 1500);
+        hot.currentIdleTime[id] = RandomInt64WithAnchor(4000, 1500);
     }
 
     // Apply pre-state change
-    uint64_t durationInState = WorldTime::GetWorldTimeMillis(stateChangeTimeStamp);
+    const EPlayerState oldState = hot.state[id];
+    uint64_t durationInState = WorldTime::GetWorldTimeMillis(hot.stateChangeTimeStamp[id]);
 
     // record by cases
     // if old state isn't offline, add duration to total online time
-    if (state != EPlayerState::Disconnected && state != EPlayerState::Offline && state != EPlayerState::None)
+    if (oldState != EPlayerState::Disconnected && oldState != EPlayerState::Offline && oldState != EPlayerState::None)
     {
-        totalOnlineTime += durationInState;   
+        hot.totalOnlineTime[id] += durationInState;   
     }
 
     // if old state was in queue, update queue time
-    if (state == EPlayerState::InQueue)
+    if (oldState == EPlayerState::InQueue)
     {
-        ++queueTimePair.first;
-        queueTimePair.second += durationInState;
+        ++hot.queueCount[id];
+        hot.queueTimeTotal[id] += durationInState;
     }
 
     // if old state was in game, update game time
-    if (state == EPlayerState::InGame)
+    if (oldState == EPlayerState::InGame)
     {
-        ++gameTimePair.first;
-        gameTimePair.second += durationInState;
+        ++hot.gameCount[id];
+        hot.gameTimeTotal[id] += durationInState;
     }
 
     // finished applying, update to new state
-    EPlayerState oldState = state;
-    state = inState;
-    stateChangeTimeStamp = WorldTime::GetWorldTimeMillis();
+    store->stats.OnStateChange(oldState, inState, hot.stateChangeTimeStamp[id], WorldTime::GetWorldTimeMillis());
+    hot.state[id] = inState;
+    hot.stateChangeTimeStamp[id] = WorldTime::GetWorldTimeMillis();
 
-    char log[128];
-    (void)sprintf_s(log, "set to state: %s", ToString(inState).c_str());
-    AddToActivityLog(log);
+    AddToActivityLog(EActivityCode::SetState, static_cast<int>(inState));
+
+    // listeners always get the handle owned by the store, so they can keep the pointer
+    VirtualPlayer* self = store->Find(id);
 
     // Notify global listeners
-    for (const auto& listener : globalListeners)
+    for (const auto& [handle, listener] : globalListeners)
     {
-        listener(this, oldState, state);
+        listener(self, oldState, inState);
     }
 
     // Notify specific state listeners
-    if (stateSpecificListeners.find(inState) != stateSpecificListeners.end())
+    auto specificListeners = stateSpecificListeners.find(inState);
+    if (specificListeners != stateSpecificListeners.end())
     {
-        for (const auto& listener : stateSpecificListeners[inState])
+        for (const auto& listener : specificListeners->second)
         {
-            listener(this, oldState, state);
+            listener(self, oldState, inState);
         }
     }
 }
 
 bool VirtualPlayer::CanChangeToState(EPlayerState inState) 
 {
-    char log[128];
+    const EPlayerState state = GetState();
     if (state == inState)
     {
-        (void)sprintf_s(log, "failed: tried setting same state: %s", ToString(inState).c_str());
-        AddToActivityLog(log);
+        AddToActivityLog(EActivityCode::FailedSameState, static_cast<int>(inState));
         return false;
     }
 
     if (state == EPlayerState::InGame && inState == EPlayerState::Offline)
     {
-        (void)sprintf_s(log, "failed: tried setting from InGame to Offline");
-        AddToActivityLog(log);
+        AddToActivityLog(EActivityCode::FailedInGameToOffline);
         return false;
     }
 
     if (state == EPlayerState::Offline && inState == EPlayerState::InQueue)
     {
-        (void)sprintf_s(log, "failed: tried setting from Offline to InQueue");
-        AddToActivityLog(log);
+        AddToActivityLog(EActivityCode::FailedOfflineToInQueue);
         return false;
     }
 
     if (state == EPlayerState::Offline && inState == EPlayerState::InGame)
     {
-        (void)sprintf_s(log, "failed: tried setting from Offline to InGame");
-        AddToActivityLog(log);
+        AddToActivityLog(EActivityCode::FailedOfflineToInGame);
         return false;
     }
     
@@ -213,9 +246,9 @@ bool VirtualPlayer::CanChangeToState(EPlayerState inState)
 
 double VirtualPlayer::GetAvgQueueTime() const
 {
-    uint64_t total = queueTimePair.second;
-    int de = queueTimePair.first;
-    if (state == EPlayerState::InQueue)
+    uint64_t total = store->hot.queueTimeTotal[id];
+    int de = store->hot.queueCount[id];
+    if (GetState() == EPlayerState::InQueue)
     {
         total += GetTimeInCurrentState();
         ++de;
@@ -225,9 +258,9 @@ double VirtualPlayer::GetAvgQueueTime() const
 
 double VirtualPlayer::GetAvgGameTime() const
 {
-    uint64_t total = gameTimePair.second;
-    int de = gameTimePair.first;
-    if (state == EPlayerState::InGame)
+    uint64_t total = store->hot.gameTimeTotal[id];
+    int de = store->hot.gameCount[id];
+    if (GetState() == EPlayerState::InGame)
     {
         total += GetTimeInCurrentState();
         ++de;
@@ -251,7 +284,7 @@ std::string VirtualPlayer::TraitsToString() const
 
 uint64_t VirtualPlayer::GetTimeInCurrentState() const
 {
-    return WorldTime::GetWorldTimeMillis(stateChangeTimeStamp);
+    return WorldTime::GetWorldTimeMillis(store->hot.stateChangeTimeStamp[id]);
 }
 
 void VirtualPlayer::GenerateOnlineTimes()
@@ -292,6 +325,7 @@ void VirtualPlayer::GenerateOnlineTimes()
 
     std::sort(stamps.begin(), stamps.end());
 
+    std::vector<std::pair<uint64_t, uint64_t>>& desiredOnlineTimes = store->cold[id].desiredOnlineTimes;
     desiredOnlineTimes.clear();
     for (int i = 0; i < static_cast<int>(stamps.size() - 1); i += 2)
     {
@@ -302,7 +336,7 @@ void VirtualPlayer::GenerateOnlineTimes()
 
 bool VirtualPlayer::GetIsInOnlineTime(uint64_t time) const
 {
-    for (std::pair<uint64_t, uint64_t> section : desiredOnlineTimes)
+    for (std::pair<uint64_t, uint64_t> section : store->cold[id].desiredOnlineTimes)
     {
         if (time >= section.first && time <= section.second)
         {
@@ -333,6 +367,7 @@ double VirtualPlayer::GetStatByTypeForSort(EPlayerSortingType type) const
 
 bool VirtualPlayer::GetNextStateChangeTimestamp(uint64_t& nextTime, EPlayerState& nextState) const
 {
+    const EPlayerState state = GetState();
     uint64_t queueTime;
     uint64_t onlineStateChangeTime;
     bool queueFirst;
@@ -376,6 +411,7 @@ uint64_t VirtualPlayer::GetNextJoinQueueTimestamp() const
 
 uint64_t VirtualPlayer::GetNextOnlineTimestamp() const
 {
+    const std::vector<std::pair<uint64_t, uint64_t>>& desiredOnlineTimes = store->cold[id].desiredOnlineTimes;
     uint64_t timeOfDay = WorldTime::GetDayProgressMillis();
     uint64_t nextTimeOfDay = timeOfDay;
     uint64_t startOfDay = WorldTime::GetWorldTimeMillis() - WorldTime::GetDayProgressMillis();
@@ -409,6 +445,7 @@ uint64_t VirtualPlayer::GetNextOnlineTimestamp() const
 
 uint64_t VirtualPlayer::GetNextOfflineTimestamp() const
 {
+    const std::vector<std::pair<uint64_t, uint64_t>>& desiredOnlineTimes = store->cold[id].desiredOnlineTimes;
     uint64_t timeOfDay = WorldTime::GetDayProgressMillis();
     uint64_t nextTimeOfDay = timeOfDay;
     uint64_t startOfDay = WorldTime::GetWorldTimeMillis() - WorldTime::GetDayProgressMillis();
@@ -443,6 +480,26 @@ uint64_t VirtualPlayer::GetNextOfflineTimestamp() const
 
 // ===== FMatch BEGIN =====
 
+void FMatch::AddPlayer(const VirtualPlayer& player)
+{
+    playerIds.push_back(player.GetId());
+    playerScores.push_back(player.GetAgr() + player.GetFle() + player.GetGri() +
+                           player.GetEdr() + player.GetIns() + player.GetCre() + player.GetPre());
+}
+
+void FMatch::Reset()
+{
+    matchId = -1;
+    playerIds.clear();
+    playerScores.clear();
+    teamOffsets.assign(1, 0);
+    matchStartTime = 0;
+    matchDuration = 3000;
+    state = EMatchState::Initiated;
+    predictedWinRates.clear();
+    winningTeam = -1;
+}
+
 void FMatch::StartMatch()
 {
     // Set a unique randomized duration for each started match, this can be affected by game mode and player stats
@@ -454,16 +511,15 @@ void FMatch::StartMatch()
 
 std::vector<float> FMatch::PredictWinProbability() const
 {
-    if (teams.size() < 2) return {1.0f}; // no opponent, no predicting
+    if (GetNumTeams() < 2) return {1.0f}; // no opponent, no predicting
 
     std::vector<int> teamScores;
-    for (const auto& team : teams)
+    for (int t = 0; t < GetNumTeams(); ++t)
     {
         int teamStrength = 0;
-        for (const VirtualPlayer& player : team)
+        for (int i = teamOffsets[t]; i < teamOffsets[t + 1]; ++i)
         {
-            teamStrength += player.GetAgr() + player.GetFle() + player.GetGri() +
-                            player.GetEdr() + player.GetIns() + player.GetCre() + player.GetPre();
+            teamStrength += playerScores[i];
         }
         teamScores.push_back(teamStrength);
     }
@@ -490,25 +546,18 @@ std::vector<float> FMatch::PredictWinProbability() const
     return probabilities;
 }
 
-void FMatch::EndMatch()
+void FMatch::EndMatch(float winnerRoll)
 {
-    if (teams.size() > 1)
+    if (GetNumTeams() > 1)
     {
-        std::vector<float> cumulativeProbs;
+        // the first team whose cumulative predicted win rate reaches the roll wins
         float cumulativeSum = 0.0f;
-        for (float p : predictedWinRates)
+        for (size_t i = 0; i < predictedWinRates.size(); ++i)
         {
-            cumulativeSum += p;
-            cumulativeProbs.push_back(cumulativeSum);
-        }
-
-        float randomValue = RandomFloat();
-
-        for (size_t i = 0; i < cumulativeProbs.size(); ++i)
-        {
-            if (randomValue <= cumulativeProbs[i])
+            cumulativeSum += predictedWinRates[i];
+            if (winnerRoll <= cumulativeSum)
             {
-                winningTeam = teams[i];
+                winningTeam = static_cast<int>(i);
                 break;
             }
         }
@@ -517,10 +566,21 @@ void FMatch::EndMatch()
     state = EMatchState::Completed;
 }
 
+int FMatch::GetTeamOfPlayer(int playerId) const
+{
+    for (int t = 0; t < GetNumTeams(); ++t)
+    {
+        for (int i = teamOffsets[t]; i < teamOffsets[t + 1]; ++i)
+        {
+            if (playerIds[i] == playerId) return t;
+        }
+    }
+    return -1;
+}
+
 bool FMatch::IsPlayerWinner(int playerId) const
 {
-    return !winningTeam.empty() && std::any_of(winningTeam.begin(), winningTeam.end(),
-        [playerId](const VirtualPlayer& player) { return player.GetId() == playerId;} );
+    return winningTeam >= 0 && IsTeamWinner(GetTeamOfPlayer(playerId));
 }
 
 FPlayerSortingTypeDisplay::FPlayerSortingTypeDisplay(EPlayerSortingType type)
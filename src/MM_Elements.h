@@ -1,11 +1,16 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <vector>
 #include <chrono>
 #include <functional>
 #include <string>
 
+#include "ActivityLog.h"
+#include "ArrayView.h"
 #include "PlayerTrait.h"
+#include "SlotMap.h"
 #include "WorldClock.h"
 
 enum EPlayerSortingType
@@ -38,8 +43,6 @@ struct FPlayerSortingTypeDisplay
 
 // ===== VIRTUAL PLAYER BEGIN =====
 
-enum EPlayerSortingType : int;
-
 // States
 enum class EPlayerState
 {
@@ -70,16 +73,59 @@ inline std::string ToString(EPlayerState state)
     return "Unknown State";
 }
 
-// base class for a player that goes online and plays matches in an imaginary game hosted by the MatchMakingSystem
+class VirtualPlayer;
+
+// ongoing match in MatchMakingSystem's match slot map, stops resolving once the match has ended
+using FMatchHandle = FSlotHandle;
+
+// intrusive links owned by MatchMakingSystem, lets a player leave the queue or a drafted pool in constant time
+struct FQueueHandle
+{
+    VirtualPlayer* prev = nullptr; // neighbours in the waiting queue
+    VirtualPlayer* next = nullptr;
+    int poolIndex = -1; // drafted pool holding the player, -1 while still waiting in the queue
+    int poolSlot = -1; // ticket of the ready team while poolIndex is readyTeam
+    bool bIsQueued = false; // waiting in the queue or drafted into a pool
+
+    static constexpr int readyTeam = -2; // drafted into a full pool that waits for the launcher
+
+    void Reset() { *this = FQueueHandle(); }
+};
+
+class FPlayerStore;
+
+// What a player takes along when moving to another MatchMakingSystem, match records stay behind
+struct FPlayerProfile
+{
+    EPlayerTrait traits = EPlayerTrait::None;
+    std::array<int, 7> stats{}; // Agr, Fle, Gri, Edr, Ins, Cre, Pre
+    std::vector<std::pair<uint64_t, uint64_t>> desiredOnlineTimes;
+
+    // shard and id the player was created with, they stay the same however often the player moves
+    int homeShard = -1;
+    int homeId = -1;
+};
+
+// Handle to a player that goes online and plays matches in an imaginary game hosted by the MatchMakingSystem.
+// The data lives in FPlayerStore columns, this class only holds the store and the id, so copies are cheap and always
+// read the current values. Accessors are defined inline in PlayerStore.h
 class VirtualPlayer
 {
 public:
     using StateChangeCallback = std::function<void(VirtualPlayer*, EPlayerState, EPlayerState)>;
 
-    // Register a listener for all state changes
-    static void RegisterOnStateChange(StateChangeCallback callback)
+    // Register a listener for all state changes, returns a handle for unregistering
+    static int RegisterOnStateChange(StateChangeCallback callback)
+    {
+        globalListeners.emplace_back(++lastListenerHandle, callback);
+        return lastListenerHandle;
+    }
+
+    static void UnregisterOnStateChange(int handle)
     {
-        globalListeners.push_back(callback);
+        globalListeners.erase(std::remove_if(globalListeners.begin(), globalListeners.end(),
+            [handle](const std::pair<int, StateChangeCallback>& entry) { return entry.first == handle; }),
+            globalListeners.end());
     }
 
     // Register a listener for a specific state
@@ -91,8 +137,11 @@ public:
     bool operator==(const VirtualPlayer& other) const { return id == other.id; }
     
     VirtualPlayer() = default;
-    VirtualPlayer(int inId); // create a player with everything randomized
-    VirtualPlayer(int inId, EPlayerTrait inTrait);
+    VirtualPlayer(FPlayerStore* inStore, int inId) : store(inStore), id(inId) {}
+    void Initialize(); // randomize everything for a newly created player
+    void Initialize(EPlayerTrait inTrait);
+    void Initialize(const FPlayerProfile& profile); // a player arriving from another system, starts Online
+    FPlayerProfile GetProfile() const; // the home stays unset for players created in this store
     
     void RegisterMatchResult(int matchId, bool bIsWon);
     void UpdateWinRate();
@@ -102,8 +151,8 @@ public:
     // information & getters
     double GetAvgQueueTime() const;
     double GetAvgGameTime() const;
-    uint64_t GetOnlineTime() const { return totalOnlineTime; }
-    int GetTotalMatchesPlayed() const { return static_cast<int>(wonMatches.size() + lostMatches.size()); }
+    uint64_t GetOnlineTime() const;
+    int GetTotalMatchesPlayed() const;
     double GetStatByTypeForSort(EPlayerSortingType type) const;
     bool GetIsInOnlineTime(uint64_t time = WorldTime::GetDayProgressMillis()) const; // check if certain time is within any section of the generated OnlineTimes
     uint64_t GetTimeInCurrentState() const;
@@ -114,71 +163,50 @@ public:
     uint64_t GetNextOfflineTimestamp() const;
     
     int GetId() const { return id; }
-    EPlayerState GetState() const { return state; }
-    std::vector<int> GetWonMatches() const { return wonMatches; }
-    std::vector<int> GetLostMatches() const { return lostMatches; }
-    std::vector<int> GetMatchHistory() const { return matchHistory; }
-    int GetOngoingMatchId() const { return ongoingMatchId; }
-    void SetOngoingMatchId(int value) { ongoingMatchId = value; }
-    double GetWinRate() const { return winRate; }
-    int GetAgr() const { return agr; }
-    int GetFle() const { return fle; }
-    int GetGri() const { return gri; }
-    int GetEdr() const { return edr; }
-    int GetIns() const { return ins; }
-    int GetCre() const { return cre; }
-    int GetPre() const { return pre; }
-    int GetTotalScore() const { return agr + fle + gri + edr + ins + cre + pre; }
-    std::vector<std::pair<uint64_t, uint64_t>> GetDesiredOnlineTimes() const { return desiredOnlineTimes; }
-    uint64_t GetCurrentIdleTime() const { return currentIdleTime; }
+    const FPlayerStore* GetStore() const { return store; }
+    EPlayerState GetState() const;
+    const std::vector<int>& GetWonMatches() const;
+    const std::vector<int>& GetLostMatches() const;
+    const std::vector<int>& GetMatchHistory() const;
+    FMatchHandle GetOngoingMatch() const;
+    void SetOngoingMatch(FMatchHandle handle);
+    double GetWinRate() const;
+    int GetAgr() const;
+    int GetFle() const;
+    int GetGri() const;
+    int GetEdr() const;
+    int GetIns() const;
+    int GetCre() const;
+    int GetPre() const;
+    int GetTotalScore() const { return GetAgr() + GetFle() + GetGri() + GetEdr() + GetIns() + GetCre() + GetPre(); }
+    const std::vector<std::pair<uint64_t, uint64_t>>& GetDesiredOnlineTimes() const;
+    uint64_t GetCurrentIdleTime() const;
     int GetSkillRating() const { return 1; } // TBD
-    std::vector<std::string> GetActivityLog() const { return activityLog; }
+    const FActivityLog& GetActivityLog() const;
+    FQueueHandle& GetQueueHandle();
+    const FQueueHandle& GetQueueHandle() const;
 
     // Trait management
     static EPlayerTrait GenerateRandomTraits();
     void ValidateTraits();
-    bool HasTrait(EPlayerTrait trait) const {return ::HasTrait(traits, trait); }
-    void AddTrait(EPlayerTrait newTrait) {traits |= newTrait; }
-    void RemoveTrait(EPlayerTrait traitToRemove) { traits = traits & ~traitToRemove; }
+    EPlayerTrait GetTraits() const;
+    bool HasTrait(EPlayerTrait trait) const {return ::HasTrait(GetTraits(), trait); }
+    void AddTrait(EPlayerTrait newTrait);
+    void RemoveTrait(EPlayerTrait traitToRemove);
     void HandleConflictTrait_PickOne(const std::vector<EPlayerTrait>& conflictingTraits); // if player has multiple of the conflicting traits, randomly (evenly) pick one and remove otehrs 
     void ApplyTraitModifiers();
-    void AddToActivityLog(std::string string);
+    void AddToActivityLog(EActivityCode code, int arg = 0);
     
     // misc
     std::string TraitsToString() const;
 
 private:
-    static std::vector<StateChangeCallback> globalListeners;
+    static std::vector<std::pair<int, StateChangeCallback>> globalListeners;
+    static int lastListenerHandle;
     static std::unordered_map<EPlayerState, std::vector<StateChangeCallback>> stateSpecificListeners;
     
-    int id;
-    EPlayerState state = EPlayerState::None;
-    EPlayerTrait traits = EPlayerTrait::None; // Supports multiple traits through bitmask
-    int ongoingMatchId = -1;
-    std::vector<int> matchHistory;
-    std::vector<int> wonMatches;
-    std::vector<int> lostMatches;
-    
-    // idle time: time when player stays online but not in queue
-    float winRate = 0.0f;
-
-    // Quantified play style
-    int agr = 0; // Aggressiveness - Willingness to take risks and engage in high-pressure plays
-    int fle = 0; // Flexibility - Ability to adapt to new strategies and opponents
-    int gri = 0; // Grit - Mental resilience and ability to recover from set-bakcs
-    int edr = 0; // Endurance - Long-term consistency across multiple matches
-    int ins = 0; // Instinct - Quick and accurate decision-making under pressure
-    int cre = 0; // Creativity - Likelihood of turning the tide unexpectedly; wildcard behavior
-    int pre = 0; // Precision - Ability to execute mechanical actions with accuracy and efficiency
-    
-    // time when last state changed. Use this to record player activity history
-    uint64_t stateChangeTimeStamp = 0;
-    uint64_t currentIdleTime = 0;
-    uint64_t totalOnlineTime = 0;
-    std::pair<int, uint64_t> queueTimePair;
-    std::pair<int, uint64_t> gameTimePair;
-    std::vector<std::pair<uint64_t, uint64_t>> desiredOnlineTimes;
-    std::vector<std::string> activityLog;
+    FPlayerStore* store = nullptr;
+    int id = -1;
     
     void GenerateOnlineTimes();
 };
@@ -212,22 +240,41 @@ struct FMatch
 {    
     // general information
     int matchId = -1;
-    std::vector<std::vector<VirtualPlayer>> teams; // supports multiple team and uneven player counts on each team
+    // participants of every team back to back, team t owns [teamOffsets[t], teamOffsets[t + 1]).
+    // supports multiple team and uneven player counts on each team
+    std::vector<int> playerIds;
+    std::vector<int> playerScores; // stat total of each participant when it joined, used for the prediction
+    std::vector<int> teamOffsets{0};
     uint64_t matchStartTime = 0;
     uint64_t matchDuration = 3000;
     EMatchState state = EMatchState::Initiated;
     std::vector<float> predictedWinRates;
 
     // end of match info
-    std::vector<VirtualPlayer> winningTeam;
+    int winningTeam = -1;
+
+    // Building, call AddPlayer for each member of a team then EndTeam
+    void AddPlayer(const VirtualPlayer& player);
+    void EndTeam() { teamOffsets.push_back(static_cast<int>(playerIds.size())); }
+    // back to a default match but keeps the vectors' capacity, for refilling one match object in a loop
+    void Reset();
 
     // Process
     void StartMatch();
     std::vector<float> PredictWinProbability() const;
-    void EndMatch();
-    
+    void EndMatch(float winnerRoll); // roll in [0, 1], drawn by the caller so matches can end on any thread
+
+    int GetNumTeams() const { return static_cast<int>(teamOffsets.size()) - 1; }
+    int GetTeamSize(int team) const { return teamOffsets[team + 1] - teamOffsets[team]; }
+    int GetPlayerId(int team, int index) const { return playerIds[teamOffsets[team] + index]; }
+    TArrayView<int> GetTeam(int team) const { return {playerIds.data() + teamOffsets[team], static_cast<size_t>(GetTeamSize(team))}; }
+    int GetTeamOfPlayer(int playerId) const;
+
+    bool IsTeamWinner(int team) const { return winningTeam >= 0 && team == winningTeam; }
     bool IsPlayerWinner(int playerId) const;
     EMatchState GetState() const { return state; }
 };
 
-// ===== VIRTUAL MATCH END =====
\ No newline at end of file
+// ===== VIRTUAL MATCH END =====
+
+#include "PlayerStore.h" // VirtualPlayer accessors read the store columns
\ No newline at end of file
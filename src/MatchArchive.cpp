@@ -0,0 +1,194 @@
+#include "MatchArchive.h"
+
+#include <iostream>
+
+void FMatchArchive::SetHotWindow(size_t matchCount)
+{
+    hotWindow = matchCount;
+    EvictOutsideHotWindow();
+}
+
+bool FMatchArchive::SetSpillFile(const std::string& path)
+{
+    if (path == spillPath) return spillPath.empty() || spillData.is_open();
+
+    spillData.close();
+    spillIndex.close();
+    spillPath = path;
+    if (path.empty()) return true;
+
+    // matches spilled to a previous file stay readable only through that file, start the new one empty
+    const std::ios::openmode mode = std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc;
+    spillData.open(path, mode);
+    spillIndex.open(path + ".idx", mode);
+    if (!spillData.is_open() || !spillIndex.is_open())
+    {
+        std::cout << "Failed to open match archive spill file: " << path << "\n";
+        spillData.close();
+        spillIndex.close();
+        return false;
+    }
+    return true;
+}
+
+void FMatchArchive::Add(const FMatch& match)
+{
+    if (chunks.empty() || chunks.back().Size() >= CHUNK_SIZE)
+    {
+        chunks.emplace_back();
+    }
+
+    FChunk& chunk = chunks.back();
+    chunk.matchIds.push_back(match.matchId);
+    chunk.startTimes.push_back(match.matchStartTime);
+    chunk.durations.push_back(match.matchDuration);
+    chunk.winningTeams.push_back(match.winningTeam);
+    for (int t = 0; t < match.GetNumTeams(); ++t)
+    {
+        for (int p = 0; p < match.GetTeamSize(t); ++p)
+        {
+            chunk.playerIds.push_back(match.GetPlayerId(t, p));
+        }
+        chunk.playerBegins.push_back(static_cast<int>(chunk.playerIds.size()));
+        chunk.predictedWinRates.push_back(t < static_cast<int>(match.predictedWinRates.size()) ? match.predictedWinRates[t] : 0.0f);
+    }
+    chunk.teamBegins.push_back(static_cast<int>(chunk.predictedWinRates.size()));
+
+    hotLookup[match.matchId] = archivedCount;
+    ++archivedCount;
+
+    EvictOutsideHotWindow();
+}
+
+bool FMatchArchive::Find(int matchId, FMatch& outMatch) const
+{
+    auto it = hotLookup.find(matchId);
+    if (it != hotLookup.end())
+    {
+        const size_t offset = it->second - firstRowInMemory;
+        ReadRow(chunks[offset / CHUNK_SIZE], offset % CHUNK_SIZE, outMatch);
+        return true;
+    }
+    return ReadSpillRecord(matchId, outMatch);
+}
+
+// only whole chunks are evicted, the oldest one goes once the newer chunks cover the window on their own
+void FMatchArchive::EvictOutsideHotWindow()
+{
+    while (hotWindow > 0 && !chunks.empty() && hotLookup.size() - chunks.front().Size() >= hotWindow)
+    {
+        EvictOldestChunk();
+    }
+}
+
+void FMatchArchive::EvictOldestChunk()
+{
+    const FChunk& chunk = chunks.front();
+    for (size_t row = 0; row < chunk.Size(); ++row)
+    {
+        hotLookup.erase(chunk.matchIds[row]);
+        if (spillData.is_open())
+        {
+            WriteSpillRecord(chunk, row);
+            ++spilledCount;
+        }
+        else
+        {
+            ++discardedCount;
+        }
+    }
+    firstRowInMemory += chunk.Size();
+    chunks.pop_front();
+}
+
+// record layout: id, start time, duration, winner, team count, then per team: player count, predicted win rate, player ids
+void FMatchArchive::WriteSpillRecord(const FChunk& chunk, size_t row)
+{
+    const int32_t matchId = chunk.matchIds[row];
+    const int32_t winner = chunk.winningTeams[row];
+    const int32_t numTeams = chunk.teamBegins[row + 1] - chunk.teamBegins[row];
+
+    spillData.seekp(0, std::ios::end);
+    const uint64_t recordStart = static_cast<uint64_t>(spillData.tellp());
+    spillData.write(reinterpret_cast<const char*>(&matchId), sizeof(matchId));
+    spillData.write(reinterpret_cast<const char*>(&chunk.startTimes[row]), sizeof(uint64_t));
+    spillData.write(reinterpret_cast<const char*>(&chunk.durations[row]), sizeof(uint64_t));
+    spillData.write(reinterpret_cast<const char*>(&winner), sizeof(winner));
+    spillData.write(reinterpret_cast<const char*>(&numTeams), sizeof(numTeams));
+    for (int team = chunk.teamBegins[row]; team < chunk.teamBegins[row + 1]; ++team)
+    {
+        const int32_t playerCount = chunk.playerBegins[team + 1] - chunk.playerBegins[team];
+        spillData.write(reinterpret_cast<const char*>(&playerCount), sizeof(playerCount));
+        spillData.write(reinterpret_cast<const char*>(&chunk.predictedWinRates[team]), sizeof(float));
+        spillData.write(reinterpret_cast<const char*>(chunk.playerIds.data() + chunk.playerBegins[team]), sizeof(int32_t) * playerCount);
+    }
+
+    // 0 marks an empty slot, so store the offset + 1
+    const uint64_t slot = recordStart + 1;
+    spillIndex.seekp(static_cast<std::streamoff>(matchId) * sizeof(uint64_t));
+    spillIndex.write(reinterpret_cast<const char*>(&slot), sizeof(slot));
+}
+
+bool FMatchArchive::ReadSpillRecord(int matchId, FMatch& outMatch) const
+{
+    if (matchId < 0 || !spillIndex.is_open()) return false;
+
+    uint64_t slot = 0;
+    spillIndex.clear();
+    spillIndex.seekg(static_cast<std::streamoff>(matchId) * sizeof(uint64_t));
+    if (!spillIndex.read(reinterpret_cast<char*>(&slot), sizeof(slot)) || slot == 0)
+    {
+        spillIndex.clear();
+        return false;
+    }
+
+    int32_t id = 0;
+    int32_t winner = -1;
+    int32_t numTeams = 0;
+    outMatch.Reset();
+    spillData.clear();
+    spillData.seekg(static_cast<std::streamoff>(slot - 1));
+    spillData.read(reinterpret_cast<char*>(&id), sizeof(id));
+    spillData.read(reinterpret_cast<char*>(&outMatch.matchStartTime), sizeof(uint64_t));
+    spillData.read(reinterpret_cast<char*>(&outMatch.matchDuration), sizeof(uint64_t));
+    spillData.read(reinterpret_cast<char*>(&winner), sizeof(winner));
+    spillData.read(reinterpret_cast<char*>(&numTeams), sizeof(numTeams));
+    for (int32_t t = 0; t < numTeams && spillData; ++t)
+    {
+        int32_t playerCount = 0;
+        float winRate = 0.0f;
+        spillData.read(reinterpret_cast<char*>(&playerCount), sizeof(playerCount));
+        spillData.read(reinterpret_cast<char*>(&winRate), sizeof(winRate));
+        const size_t first = outMatch.playerIds.size();
+        outMatch.playerIds.resize(first + playerCount);
+        spillData.read(reinterpret_cast<char*>(outMatch.playerIds.data() + first), sizeof(int32_t) * playerCount);
+        outMatch.predictedWinRates.push_back(winRate);
+        outMatch.EndTeam();
+    }
+
+    if (!spillData || id != matchId)
+    {
+        spillData.clear();
+        return false;
+    }
+    outMatch.matchId = id;
+    outMatch.winningTeam = winner;
+    outMatch.state = EMatchState::Completed;
+    return true;
+}
+
+void FMatchArchive::ReadRow(const FChunk& chunk, size_t row, FMatch& outMatch)
+{
+    outMatch.Reset();
+    outMatch.matchId = chunk.matchIds[row];
+    outMatch.matchStartTime = chunk.startTimes[row];
+    outMatch.matchDuration = chunk.durations[row];
+    outMatch.winningTeam = chunk.winningTeams[row];
+    outMatch.state = EMatchState::Completed;
+    for (int team = chunk.teamBegins[row]; team < chunk.teamBegins[row + 1]; ++team)
+    {
+        outMatch.playerIds.insert(outMatch.playerIds.end(), chunk.playerIds.begin() + chunk.playerBegins[team], chunk.playerIds.begin() + chunk.playerBegins[team + 1]);
+        outMatch.predictedWinRates.push_back(chunk.predictedWinRates[team]);
+        outMatch.EndTeam();
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "MM_Elements.h"
+
+/*
+ * Append only store of completed matches.
+ * Matches are kept column by column in fixed size chunks. Only the newest chunks covering the hot window stay in memory,
+ * older chunks are written to the spill file when one is set and dropped otherwise, so memory stays flat no matter how
+ * long the simulation runs.
+ * The spill file holds one variable length record per match, a second file (spill path + ".idx") maps a match id to its
+ * record through a fixed 8 byte slot per id, so finding a spilled match needs no in-memory index either.
+ */
+class FMatchArchive
+{
+public:
+    static constexpr size_t CHUNK_SIZE = 4096; // matches per in-memory chunk
+
+    FMatchArchive() = default;
+    FMatchArchive(const FMatchArchive&) = delete;
+    FMatchArchive& operator=(const FMatchArchive&) = delete;
+
+    // keeps at least this many of the newest matches in memory, rounded up to whole chunks. 0 keeps every match
+    void SetHotWindow(size_t matchCount);
+    size_t GetHotWindow() const { return hotWindow; }
+
+    // evicted matches are written to this file, an empty path discards them. Returns false if the file can't be created
+    bool SetSpillFile(const std::string& path);
+    const std::string& GetSpillFile() const { return spillPath; }
+
+    void Add(const FMatch& match);
+
+    // rebuilds a completed match, false if it was never archived or has been discarded.
+    // playerScores are not archived, so the returned match only carries the predicted win rates
+    bool Find(int matchId, FMatch& outMatch) const;
+
+    size_t Size() const { return archivedCount; }
+    size_t GetInMemoryCount() const { return hotLookup.size(); }
+    size_t GetSpilledCount() const { return spilledCount; }
+    size_t GetDiscardedCount() const { return discardedCount; }
+
+private:
+    // one block of matches stored as columns, rows are in the order the matches completed
+    struct FChunk
+    {
+        std::vector<int> matchIds;
+        std::vector<uint64_t> startTimes;
+        std::vector<uint64_t> durations;
+        std::vector<int> winningTeams;
+        std::vector<int> teamBegins{0};       // first team row of each match, one extra entry closes the last match
+        std::vector<int> playerBegins{0};     // first player row of each team, one extra entry closes the last team
+        std::vector<float> predictedWinRates; // one per team row
+        std::vector<int> playerIds;
+
+        size_t Size() const { return matchIds.size(); }
+    };
+
+    std::deque<FChunk> chunks;
+    std::unordered_map<int, size_t> hotLookup; // match id -> archive row, only for matches still in memory
+    size_t firstRowInMemory = 0; // archive row of the first match in chunks.front()
+    size_t hotWindow = 0;
+
+    size_t archivedCount = 0;
+    size_t spilledCount = 0;
+    size_t discardedCount = 0;
+
+    std::string spillPath;
+    mutable std::fstream spillData;
+    mutable std::fstream spillIndex;
+
+    void EvictOutsideHotWindow();
+    void EvictOldestChunk();
+    void WriteSpillRecord(const FChunk& chunk, size_t row);
+    bool ReadSpillRecord(int matchId, FMatch& outMatch) const;
+    static void ReadRow(const FChunk& chunk, size_t row, FMatch& outMatch);
+};
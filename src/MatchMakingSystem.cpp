@@ -2,6 +2,8 @@
 
 #include <iomanip>
 #include <algorithm>
+#include <chrono>
+#include <iterator>
 #include <numeric>
 
 #include "MM_Elements.h"
@@ -12,8 +14,10 @@
 MatchMakingSystem::MatchMakingSystem(EMatchMakeAlgorithm SelectedAlgorithm) : algorithm(SelectedAlgorithm)
 {
     // delegate binds
-    VirtualPlayer::RegisterOnStateChange([this](VirtualPlayer* player, EPlayerState oldState, EPlayerState newState)
+    // listeners are shared by every system, only react to the players of this one
+    stateChangeListenerHandle = VirtualPlayer::RegisterOnStateChange([this](VirtualPlayer* player, EPlayerState oldState, EPlayerState newState)
     {
+        if (player->GetStore() != &allPlayers) return;
         this->OnPlayerStateChange(player, oldState, newState);
     });
 
@@ -21,20 +25,137 @@ MatchMakingSystem::MatchMakingSystem(EMatchMakeAlgorithm SelectedAlgorithm) : al
     for (int i = 0; i < static_cast<int>(EPlayerSortingType::IterationRef); ++i)
     {
         EPlayerSortingType type = static_cast<EPlayerSortingType>(i);
-        TopLists[type] = {};
-        BottomLists[type] = {};
+        TopLists[type] = FLeaderList(true);
+        BottomLists[type] = FLeaderList(false);
     }
+
+    // rank indices over the whole population
+    rankIndices.resize(static_cast<size_t>(EPlayerSortingType::IterationRef));
+
+    // every phase reads what the one before it changed, so the edges form a chain. Bulk work inside a phase is
+    // split with ParallelFor on the same job system. A phase may run on any thread, it draws from the generator of
+    // the thread that called Update
+    auto AddPhase = [this](FJobGraph& graph, const char* name, void (MatchMakingSystem::*phase)(), const std::vector<FJobGraph::FTaskId>& dependencies)
+    {
+        return graph.AddTask(name, [this, phase]
+        {
+            FScopedRandomGenerator scopedRandom(updateRandom);
+            (this->*phase)();
+        }, dependencies);
+    };
+    for (FJobGraph* graph : {&updateGraph, &pipelinedUpdateGraph})
+    {
+        const FJobGraph::FTaskId creationTask = AddPhase(*graph, "CheckPlayerCreation", &MatchMakingSystem::Update_CheckPlayerCreation, {});
+        const FJobGraph::FTaskId matchesTask = AddPhase(*graph, "Matches", &MatchMakingSystem::Update_Matches, {creationTask});
+        const FJobGraph::FTaskId routineTask = AddPhase(*graph, "PlayerRoutine", &MatchMakingSystem::Update_PlayerRoutine, {matchesTask});
+        if (graph == &updateGraph)
+        {
+            const FJobGraph::FTaskId draftTask = AddPhase(*graph, "DraftQueuedPlayers", &MatchMakingSystem::Update_DraftQueuedPlayers, {routineTask});
+            AddPhase(*graph, "StartMatchFromQueuedPools", &MatchMakingSystem::Update_StartMatchFromQueuedPools, {draftTask});
+        }
+        else
+        {
+            // the stages only share readyTeams. The drafter draws no random numbers, updateRandom belongs to the launcher
+            graph->AddTask("DraftStage", [this] { Update_DraftStage(); }, {routineTask});
+            AddPhase(*graph, "LaunchStage", &MatchMakingSystem::Update_LaunchStage, {routineTask});
+        }
+    }
+
+    ownedJobSystem = std::make_unique<FJobSystem>(1);
+    jobSystem = ownedJobSystem.get();
+}
+
+MatchMakingSystem::~MatchMakingSystem()
+{
+    VirtualPlayer::UnregisterOnStateChange(stateChangeListenerHandle);
+}
+
+void MatchMakingSystem::SetWorldSetting(const FWorldSetting& Settings)
+{
+    WorldSetting = Settings;
+    const int numThreads = (std::max)(WorldSetting.workerThreads, 1);
+    if (ownedJobSystem && numThreads != ownedJobSystem->GetNumThreads())
+    {
+        ownedJobSystem = std::make_unique<FJobSystem>(numThreads);
+        jobSystem = ownedJobSystem.get();
+    }
+    matchArchive.SetHotWindow(static_cast<size_t>((std::max)(WorldSetting.matchArchiveWindow, 0)));
+    matchArchive.SetSpillFile(WorldSetting.matchArchiveFile);
+}
+
+bool MatchMakingSystem::FindMatch(int matchId, FMatch& outMatch) const
+{
+    const auto ongoing = ongoingMatchHandles.find(matchId);
+    if (ongoing != ongoingMatchHandles.end())
+    {
+        if (const FMatch* match = ongoingMatches.Find(ongoing->second))
+        {
+            outMatch = *match;
+            return true;
+        }
+    }
+    return matchArchive.Find(matchId, outMatch);
+}
+
+void MatchMakingSystem::SetJobSystem(FJobSystem* sharedJobSystem)
+{
+    // a shared system replaces the own one, so no idle threads are left behind
+    ownedJobSystem = sharedJobSystem ? nullptr : std::make_unique<FJobSystem>((std::max)(WorldSetting.workerThreads, 1));
+    jobSystem = sharedJobSystem ? sharedJobSystem : ownedJobSystem.get();
 }
 
 void MatchMakingSystem::Update()
 {
-    Update_CheckPlayerCreation();
-    
-    Update_Matches();
-    Update_PlayerRoutine();
+    // teams still waiting after the pipeline was switched off go back to the queue
+    if (!WorldSetting.bPipelinedDraft)
+    {
+        while (FReadyTeam* team = readyTeams.GetReadSlot())
+        {
+            returnedPlayers.insert(returnedPlayers.end(), team->players.begin(), team->players.end());
+            readyTeams.Pop();
+        }
+    }
+    RequeueReturnedPlayers();
+    readyTeamsAtUpdateStart = readyTeams.Size();
+
+    updateRandom = rng;
+    jobSystem->Run(WorldSetting.bPipelinedDraft ? pipelinedUpdateGraph : updateGraph);
+    rng = updateRandom;
+}
+
+uint64_t MatchMakingSystem::GetNextEventTime() const
+{
+    const uint64_t now = WorldTime::GetWorldTimeMillis();
+    uint64_t nextTime = UINT64_MAX;
+
+    // drafting runs every update while there are queued players and room for more pools
+    if (!queuedPlayers.IsEmpty() && draftedPools.size() + readyTeams.Size() < maxDraftablePools)
+    {
+        return now;
+    }
+    if (!returnedPlayers.empty())
+    {
+        return now;
+    }
+
+    nextTime = (std::min)(nextTime, playersStateEvents.GetNextTime());
+
+    nextTime = (std::min)(nextTime, matchEndEvents.GetNextTime());
+
+    // pool check only matters when a pool is full
+    bool bHasFullPool = std::any_of(draftedPools.begin(), draftedPools.end(),
+        [this](const std::vector<VirtualPlayer*>& pool) { return static_cast<int>(pool.size()) == MatchSetting.numTeams * MatchSetting.teamSize; });
+    if (bHasFullPool || readyTeams.Size() > 0)
+    {
+        nextTime = (std::min)(nextTime, lastPoolCheckTime + MatchSetting.draftedPoolCheckInterval);
+    }
+
+    if (playersToCreate > 0)
+    {
+        nextTime = (std::min)(nextTime, lastPlayerCreationCheckTime + WorldSetting.playerCreationCheckInterval);
+    }
 
-    Update_DraftQueuedPlayers();
-    Update_StartMatchFromQueuedPools();
+    return nextTime < now ? now : nextTime;
 }
 
 void MatchMakingSystem::Update_CheckPlayerCreation()
@@ -61,16 +182,92 @@ void MatchMakingSystem::Update_CheckPlayerCreation()
 
 void MatchMakingSystem::CreatePlayer()
 {
-    int id = static_cast<int>(allPlayersLookupMap.size());
-    allPlayersLookupMap.emplace(id, VirtualPlayer(id));
-    ReportToLeaderLists(EPlayerSortingType::Aggressiveness, allPlayersLookupMap.find(id)->second);
-    ReportToLeaderLists(EPlayerSortingType::Flexibility, allPlayersLookupMap.find(id)->second);
-    ReportToLeaderLists(EPlayerSortingType::Grit, allPlayersLookupMap.find(id)->second);
-    ReportToLeaderLists(EPlayerSortingType::Endurance, allPlayersLookupMap.find(id)->second);
-    ReportToLeaderLists(EPlayerSortingType::Instinct, allPlayersLookupMap.find(id)->second);
-    ReportToLeaderLists(EPlayerSortingType::Creativity, allPlayersLookupMap.find(id)->second);
-    ReportToLeaderLists(EPlayerSortingType::Precision, allPlayersLookupMap.find(id)->second);
-    ReportToLeaderLists(EPlayerSortingType::TotalScore, allPlayersLookupMap.find(id)->second);
+    RegisterNewPlayer(allPlayers.Create());
+}
+
+void MatchMakingSystem::AdmitPlayers(const std::vector<FPlayerProfile>& players)
+{
+    for (const FPlayerProfile& profile : players)
+    {
+        // returning players get the row they were parked in, with their match records from the earlier stay
+        VirtualPlayer* player = nullptr;
+        const uint64_t homeKey = (static_cast<uint64_t>(static_cast<uint32_t>(profile.homeShard)) << 32) | static_cast<uint32_t>(profile.homeId);
+        if (profile.homeShard == shardIndex)
+        {
+            player = allPlayers.Find(profile.homeId);
+        }
+        else if (auto row = admittedRows.find(homeKey); row != admittedRows.end())
+        {
+            player = &allPlayers[row->second];
+        }
+
+        if (player != nullptr && player->GetState() == EPlayerState::None)
+        {
+            player->Initialize(profile);
+        }
+        else
+        {
+            player = &allPlayers.Create(profile);
+            admittedRows[homeKey] = player->GetId();
+        }
+        RegisterNewPlayer(*player);
+        player->SetState(EPlayerState::InQueue);
+    }
+}
+
+void MatchMakingSystem::ReleaseLongWaitingPlayers(uint64_t minQueueTime, size_t maxCount, std::vector<FPlayerProfile>& outPlayers)
+{
+    // waiting in the queue first, oldest first, then drafted into pools that haven't filled up
+    std::vector<VirtualPlayer*> releasing;
+    for (VirtualPlayer* player = queuedPlayers.Front(); player != nullptr && releasing.size() < maxCount; player = player->GetQueueHandle().next)
+    {
+        if (player->GetTimeInCurrentState() >= minQueueTime) { releasing.push_back(player); }
+    }
+    for (const std::vector<VirtualPlayer*>& pool : draftedPools)
+    {
+        for (VirtualPlayer* player : pool)
+        {
+            if (releasing.size() >= maxCount) break;
+            if (player->GetTimeInCurrentState() >= minQueueTime) { releasing.push_back(player); }
+        }
+    }
+
+    for (VirtualPlayer* player : releasing)
+    {
+        outPlayers.push_back(player->GetProfile());
+        if (outPlayers.back().homeShard < 0)
+        {
+            outPlayers.back().homeShard = shardIndex;
+            outPlayers.back().homeId = player->GetId();
+        }
+
+        // parked in None for good: the state listener takes it out of the queue and nothing schedules it again
+        player->SetState(EPlayerState::None, true);
+        for (int i = 0; i < static_cast<int>(EPlayerSortingType::IterationRef); ++i)
+        {
+            EPlayerSortingType type = static_cast<EPlayerSortingType>(i);
+            TopLists[type].Remove(player->GetId());
+            BottomLists[type].Remove(player->GetId());
+            rankIndices[i].Remove(player->GetId());
+        }
+    }
+}
+
+void MatchMakingSystem::RegisterNewPlayer(const VirtualPlayer& player)
+{
+    ReportToLeaderLists(EPlayerSortingType::Aggressiveness, player);
+    ReportToLeaderLists(EPlayerSortingType::Flexibility, player);
+    ReportToLeaderLists(EPlayerSortingType::Grit, player);
+    ReportToLeaderLists(EPlayerSortingType::Endurance, player);
+    ReportToLeaderLists(EPlayerSortingType::Instinct, player);
+    ReportToLeaderLists(EPlayerSortingType::Creativity, player);
+    ReportToLeaderLists(EPlayerSortingType::Precision, player);
+    ReportToLeaderLists(EPlayerSortingType::TotalScore, player);
+
+    for (int i = 0; i < static_cast<int>(EPlayerSortingType::IterationRef); ++i)
+    {
+        rankIndices[i].Set(player.GetId(), player.GetStatByTypeForSort(static_cast<EPlayerSortingType>(i)));
+    }
 }
 
 void MatchMakingSystem::OnPlayerStateChange(VirtualPlayer* player, EPlayerState oldState, EPlayerState newState)
@@ -86,7 +283,7 @@ void MatchMakingSystem::OnPlayerStateChange(VirtualPlayer* player, EPlayerState
         bool bIsQueued = AddPlayerToQueue(player);
         if (!bIsQueued)
         {
-            player->AddToActivityLog("failed to join queue");
+            player->AddToActivityLog(EActivityCode::FailedToJoinQueue);
             player->SetState(EPlayerState::Online);
         }
     }
@@ -96,53 +293,61 @@ void MatchMakingSystem::OnPlayerStateChange(VirtualPlayer* player, EPlayerState
     EPlayerState nextState;
     if (player->GetNextStateChangeTimestamp(nextTime, nextState))
     {
-        playersStateEvent.push(FPlayersStateEvent(nextTime, player->GetId(), nextState));
-        char log[128];
-        (void)sprintf_s(log, "scheduled to %s", ToString(nextState).c_str());
-        player->AddToActivityLog(log);
+        playersStateEvents.Schedule(player->GetId(), nextTime, nextState);
+        player->AddToActivityLog(EActivityCode::ScheduledState, static_cast<int>(nextState));
+    }
+    else
+    {
+        // nothing planned for this state (e.g. in game), drop whatever was scheduled for the old one
+        playersStateEvents.Cancel(player->GetId());
     }
-
-    // Update state map
-    bool bFound = playerStateMap.find(oldState) != playerStateMap.end();
-    playerStateMap.insert_or_assign(oldState, bFound ? playerStateMap.find(oldState)->second - 1 : 0);
-    bFound = playerStateMap.find(newState) != playerStateMap.end();
-    playerStateMap.insert_or_assign(newState, bFound ? playerStateMap.find(newState)->second + 1 : 1);
 }
 
 void MatchMakingSystem::Update_PlayerRoutine()
 {
-    int MAX_EVENTS_PER_FRAME = (static_cast<int>(allPlayersLookupMap.size()) / 100) + 5; // Batch size per frame
-    int eventProcessed = 0;
-    
-    while (!playersStateEvent.empty()
-        && playersStateEvent.top().time <= WorldTime::GetWorldTimeMillis()
-        && eventProcessed < MAX_EVENTS_PER_FRAME)
+    const uint64_t now = WorldTime::GetWorldTimeMillis();
+    const bool bHasBudget = WorldSetting.eventBudgetMicros > 0;
+    const auto budgetEndTime = std::chrono::steady_clock::now() + std::chrono::microseconds(WorldSetting.eventBudgetMicros);
+    bool bBudgetExhausted = false;
+
+    // with a budget, events are pulled in small batches so the clock is checked every so often
+    while (!bBudgetExhausted)
     {
-        FPlayersStateEvent event = playersStateEvent.top();
-        playersStateEvent.pop();
-        ++eventProcessed;
+        dueStateEvents.clear();
+        playersStateEvents.ExtractDue(now, dueStateEvents, bHasBudget ? eventBatchSize : SIZE_MAX);
+        if (dueStateEvents.empty()) break;
 
-        auto it = allPlayersLookupMap.find(event.playerId);
-        if (it == allPlayersLookupMap.end()) continue;
-        
-        VirtualPlayer* player = &it->second;
-        player->SetState(event.newState);
+        counters.stateEventsProcessed += dueStateEvents.size();
+        for (const FPlayersStateEventWheel::FEntry& event : dueStateEvents)
+        {
+            const double lateness = static_cast<double>(now - event.time);
+            counters.stateEventLateness.Add(lateness);
+            histograms.stateEventLateness.Add(lateness);
+
+            VirtualPlayer* player = allPlayers.Find(event.handle);
+            if (player == nullptr) continue;
+
+            player->SetState(event.payload);
+        }
+
+        bBudgetExhausted = bHasBudget && std::chrono::steady_clock::now() >= budgetEndTime;
     }
 
-    if (eventProcessed >= MAX_EVENTS_PER_FRAME)
+    // whatever is still due waits for the next update, count it so a slow simulator shows up in the reports
+    counters.stateEventBacklog = bBudgetExhausted ? playersStateEvents.CountDue(now) : 0;
+    if (counters.stateEventBacklog > 0)
     {
-        //std::cout << "hitting max event per frame! \n";
+        ++counters.budgetExhaustedUpdates;
+        counters.peakStateEventBacklog = (std::max)(counters.peakStateEventBacklog, counters.stateEventBacklog);
     }
 }
 
 void MatchMakingSystem::Update_DraftQueuedPlayers()
 {
-    size_t maxDraftablePools = 100;
-    while (!queuedPlayers.empty() && draftedPools.size() < maxDraftablePools)
+    while (!queuedPlayers.IsEmpty() && draftedPools.size() < maxDraftablePools)
     {
-        VirtualPlayer* player = (algorithm == LIFO) ? queuedPlayers.back() : queuedPlayers.front();
-        (algorithm == LIFO) ? queuedPlayers.pop_back() : queuedPlayers.pop_front();
-        TryAssignPlayerToTeam(player);
+        VirtualPlayer* player = (algorithm == LIFO) ? queuedPlayers.Back() : queuedPlayers.Front();
+        TryAssignPlayerToTeam(player); // takes the player out of the waiting queue
     }
 }
 
@@ -151,13 +356,18 @@ void MatchMakingSystem::Update_StartMatchFromQueuedPools()
     if(!GetWorldClock().CheckUpdateDelay(MatchSetting.draftedPoolCheckInterval, lastPoolCheckTime)){ return; }
     
     int startedMatches = 0;
-    for (auto it = draftedPools.begin(); it != draftedPools.end(); )
+    for (size_t poolIndex = 0; poolIndex < draftedPools.size(); )
     {
-        if (static_cast<int>(it->size()) == MatchSetting.numTeams * MatchSetting.teamSize)
+        if (static_cast<int>(draftedPools[poolIndex].size()) == MatchSetting.numTeams * MatchSetting.teamSize)
         {
-            std::vector<VirtualPlayer*> newJoinedPlayers = StartMatch(*it);
-            
-            it = draftedPools.erase(it);
+            StartMatch(draftedPools[poolIndex]);
+
+            // players leave the queue with the pool, the last pool moves into this index and is checked next
+            for (VirtualPlayer* player : draftedPools[poolIndex])
+            {
+                player->GetQueueHandle().Reset();
+            }
+            RemoveDraftedPool(poolIndex);
             if (++startedMatches >= MatchSetting.matchesPerCycle)
             {
                 break;
@@ -165,39 +375,116 @@ void MatchMakingSystem::Update_StartMatchFromQueuedPools()
         }
         else
         {
-            ++it;   
+            ++poolIndex;   
+        }
+    }
+}
+
+void MatchMakingSystem::Update_DraftStage()
+{
+    const size_t teamPlayers = static_cast<size_t>(MatchSetting.numTeams * MatchSetting.teamSize);
+    const uint64_t now = WorldTime::GetWorldTimeMillis();
+
+    // the launcher only takes teams out of the ring, counting from the update start keeps the limit the same on any thread
+    size_t readyCount = readyTeamsAtUpdateStart;
+    while (!queuedPlayers.IsEmpty() && draftedPools.size() + readyCount < maxDraftablePools)
+    {
+        VirtualPlayer* player = (algorithm == LIFO) ? queuedPlayers.Back() : queuedPlayers.Front();
+        TryAssignPlayerToTeam(player);
+
+        const FQueueHandle& handle = player->GetQueueHandle();
+        if (handle.poolIndex < 0 || draftedPools[handle.poolIndex].size() != teamPlayers) continue;
+
+        // hand the full pool over, its players wait for the launcher with the team's ticket
+        const size_t poolIndex = static_cast<size_t>(handle.poolIndex);
+        FReadyTeam* team = readyTeams.GetWriteSlot();
+        team->players.assign(draftedPools[poolIndex].begin(), draftedPools[poolIndex].end());
+        team->readyTime = now;
+        team->ticket = nextTeamTicket++;
+        for (VirtualPlayer* teamPlayer : team->players)
+        {
+            FQueueHandle& teamHandle = teamPlayer->GetQueueHandle();
+            teamHandle.poolIndex = FQueueHandle::readyTeam;
+            teamHandle.poolSlot = team->ticket;
+        }
+        RemoveDraftedPool(poolIndex);
+        readyTeams.Push();
+        ++readyCount;
+    }
+}
+
+void MatchMakingSystem::Update_LaunchStage()
+{
+    if(!GetWorldClock().CheckUpdateDelay(MatchSetting.draftedPoolCheckInterval, lastPoolCheckTime)){ return; }
+
+    const uint64_t now = WorldTime::GetWorldTimeMillis();
+    int startedMatches = 0;
+    for (size_t i = 0; i < readyTeamsAtUpdateStart && startedMatches < MatchSetting.matchesPerCycle; ++i)
+    {
+        FReadyTeam* team = readyTeams.GetReadSlot();
+        auto isWaiting = [team](VirtualPlayer* player)
+        {
+            const FQueueHandle& handle = player->GetQueueHandle();
+            return handle.bIsQueued && handle.poolIndex == FQueueHandle::readyTeam && handle.poolSlot == team->ticket;
+        };
+
+        if (std::all_of(team->players.begin(), team->players.end(), isWaiting))
+        {
+            StartMatch(team->players);
+            for (VirtualPlayer* player : team->players)
+            {
+                player->GetQueueHandle().Reset();
+            }
+            const double wait = static_cast<double>(now - team->readyTime);
+            counters.readyTeamWait.Add(wait);
+            histograms.readyTeamWait.Add(wait);
+            ++startedMatches;
+        }
+        else
+        {
+            // somebody left the queue since the pool filled up, the rest have to be drafted again
+            std::copy_if(team->players.begin(), team->players.end(), std::back_inserter(returnedPlayers), isWaiting);
         }
+        readyTeams.Pop();
     }
 }
 
-std::vector<VirtualPlayer*> MatchMakingSystem::StartMatch(const std::vector<VirtualPlayer*>& draftedTeam)
+void MatchMakingSystem::RequeueReturnedPlayers()
+{
+    for (VirtualPlayer* player : returnedPlayers)
+    {
+        // players that left the queue meanwhile got their handle reset
+        FQueueHandle& handle = player->GetQueueHandle();
+        if (handle.bIsQueued && handle.poolIndex == FQueueHandle::readyTeam)
+        {
+            handle.Reset();
+            handle.bIsQueued = true;
+            queuedPlayers.PushBack(player);
+        }
+    }
+    returnedPlayers.clear();
+}
+
+FMatchHandle MatchMakingSystem::StartMatch(const std::vector<VirtualPlayer*>& draftedTeam)
 {
     if(draftedTeam.empty()) return {};
 
     FMatch newMatch;
-    static std::vector<VirtualPlayer*> joinedPlayer;
     // set expected avg, StartMatch function will determine the actual match time, because this could be affected by player traits
-    newMatch.matchId = static_cast<int>(allMatchesLookupMap.size());
+    newMatch.matchId = static_cast<int>(nextMatchId++);
     newMatch.matchDuration = MatchSetting.matchDuration;
 
     for (int t = 0; t < MatchSetting.numTeams; ++t)
     {
-        std::vector<VirtualPlayer> team;
         for (int j = 0; j < MatchSetting.teamSize; ++j)
         {
             int index = t * MatchSetting.teamSize + j;
             if (index < static_cast<int>(draftedTeam.size()))
             {
                 VirtualPlayer* player = draftedTeam[index];
-                team.emplace_back(*player);
-                player->SetOngoingMatchId(newMatch.matchId);
+                newMatch.AddPlayer(*player);
                 player->SetState(EPlayerState::InGame);
-                
-                char log[128];
-                (void)sprintf_s(log, "joined match: %d", newMatch.matchId);
-                player->AddToActivityLog(log);
-                
-                joinedPlayer.push_back(player); // saving a copy here for more complicated logic later. e.g. SetState
+                player->AddToActivityLog(EActivityCode::JoinedMatch, newMatch.matchId);
             }
             else
             {
@@ -205,97 +492,116 @@ std::vector<VirtualPlayer*> MatchMakingSystem::StartMatch(const std::vector<Virt
                 std::cout << "Starting a match with at least one invalid players \n";
             }
         }
-        newMatch.teams.push_back(std::move(team));
-    }
-/*
-    for (VirtualPlayer* player : joinedPlayer)
-    {
-        player->SetState(EPlayerState::InGame);
-        player->SetOngoingMatchId(newMatch.matchId);
+        newMatch.EndTeam();
     }
- */
+    if (newMatch.playerIds.empty()) return {};
     
     newMatch.StartMatch();
-    allMatchesLookupMap.emplace(newMatch.matchId, newMatch);
-    ongoingMatchIds.insert(newMatch.matchId);
-    return joinedPlayer;
+    ++counters.matchesStarted;
+    const FMatchHandle handle = ongoingMatches.Insert(std::move(newMatch));
+
+    const FMatch& match = *ongoingMatches.Find(handle);
+    ongoingMatchHandles[match.matchId] = handle;
+    for (int playerId : match.playerIds)
+    {
+        allPlayers[playerId].SetOngoingMatch(handle);
+    }
+    matchEndEvents.Schedule(static_cast<int>(handle.index), match.matchStartTime + match.matchDuration, handle.generation);
+    return handle;
 }
 
 void MatchMakingSystem::Update_Matches()
 {
-    if (ongoingMatchIds.empty())
+    if (matchEndEvents.IsEmpty())
     {
         return;
     }
 
     //START_PERF_MEASURE(Matches)
-    std::vector<FMatch*> queuedMatches;
-    for (int matchId : ongoingMatchIds)
+    // only matches whose end time has passed come out of the wheel, in end time order
+    dueMatchEnds.clear();
+    matchEndEvents.ExtractDue(WorldTime::GetWorldTimeMillis(), dueMatchEnds);
+
+    // winners are rolled here in end time order, so the outcome doesn't depend on which thread ends which match
+    endingMatches.clear();
+    for (const FMatchEndWheel::FEntry& matchEnd : dueMatchEnds)
     {
-        auto it = allMatchesLookupMap.find(matchId);
-        if (it != allMatchesLookupMap.end())
+        const FMatchHandle handle{static_cast<uint32_t>(matchEnd.handle), matchEnd.payload};
+        if (FMatch* match = ongoingMatches.Find(handle))
         {
-            queuedMatches.emplace_back(&(it->second));
+            endingMatches.push_back({handle, match, match->matchId, RandomFloat()});
         }
     }
-    
-    for (FMatch* match : queuedMatches)
+    if (endingMatches.empty()) return;
+
+    // matches don't share players, ending one only writes to the match and its own players
+    auto EndMatches = [this](size_t begin, size_t end)
     {
-        if (WorldTime::GetWorldTimeMillis(match->matchStartTime) >= match->matchDuration)
+        for (size_t i = begin; i < end; ++i)
         {
-            // conclude match
-            match->EndMatch();
-            
-            for (const std::vector<VirtualPlayer>& team : match->teams)
+            FMatch& match = *endingMatches[i].match;
+            match.EndMatch(endingMatches[i].winnerRoll);
+            for (int t = 0; t < match.GetNumTeams(); ++t)
             {
-                for (const VirtualPlayer& p : team)
+                for (int p = 0; p < match.GetTeamSize(t); ++p)
                 {
-                    if (auto it = allPlayersLookupMap.find(p.GetId()); it != allPlayersLookupMap.end())
+                    if (VirtualPlayer* player = allPlayers.Find(match.GetPlayerId(t, p)))
                     {
-                        it->second.RegisterMatchResult(match->matchId, match->IsPlayerWinner(it->first));
-
-                        char log[128];
-                        (void)sprintf_s(log, "match %d ended", match->matchId);
-                        it->second.AddToActivityLog(log);
-                        
-                        it->second.SetState(it->second.GetIsInOnlineTime() ? EPlayerState::Online : EPlayerState::Offline, true);
+                        player->RegisterMatchResult(match.matchId, match.IsTeamWinner(t));
+                        player->AddToActivityLog(EActivityCode::MatchEnded, match.matchId);
+                        player->SetOngoingMatch({});
+                    }
+                }
+            }
+        }
+    };
+    jobSystem->ParallelFor("EndMatches", endingMatches.size(), minMatchesPerChunk, EndMatches);
 
-                        if (it->second.GetTotalMatchesPlayed() > MatchSetting.minGameThresholdForList)
-                        {
-                            ReportToLeaderLists(EPlayerSortingType::WinRate, it->second);
-                        }
+    // shared state (rank index, state change events, leader lists, archive) is merged on this thread in end time order
+    for (const FEndingMatch& ending : endingMatches)
+    {
+        const FMatch& match = *ending.match;
+        for (int playerId : match.playerIds)
+        {
+            if (VirtualPlayer* player = allPlayers.Find(playerId))
+            {
+                rankIndices[WinRate].Set(player->GetId(), player->GetWinRate());
+                player->SetState(player->GetIsInOnlineTime() ? EPlayerState::Online : EPlayerState::Offline, true);
 
-                        it->second.SetOngoingMatchId(-1);
-                    }
+                if (player->GetTotalMatchesPlayed() > MatchSetting.minGameThresholdForList)
+                {
+                    ReportToLeaderLists(EPlayerSortingType::WinRate, *player);
                 }
             }
-            ongoingMatchIds.erase(match->matchId);
         }
+        matchArchive.Add(match);
+        ++counters.matchesCompleted;
+    }
+
+    // removing moves matches inside the slot map, so it waits until the pointers above are done with and only uses ids
+    for (const FEndingMatch& ending : endingMatches)
+    {
+        ongoingMatchHandles.erase(ending.matchId);
+        ongoingMatches.Remove(ending.handle);
     }
 }
 
 void MatchMakingSystem::ReportToLeaderLists(EPlayerSortingType type, const VirtualPlayer& player)
 {
-    const auto& it_top = std::find(TopLists[type].begin(), TopLists[type].end(), player);
-    it_top == TopLists[type].end() ? TopLists[type].push_back(player) : *it_top = player;
-    const auto& it_bot = std::find(BottomLists[type].begin(), BottomLists[type].end(), player);
-    it_bot == BottomLists[type].end() ? BottomLists[type].push_back(player) : *it_bot = player;
-    
-    std::sort(TopLists[type].begin(), TopLists[type].end(), [type](const VirtualPlayer& a, const VirtualPlayer& b){return a.GetStatByTypeForSort(type) > b.GetStatByTypeForSort(type);});
-    std::sort(BottomLists[type].begin(), BottomLists[type].end(),[type](const VirtualPlayer& a, const VirtualPlayer& b){return a.GetStatByTypeForSort(type) < b.GetStatByTypeForSort(type);});
-
-    if(static_cast<int>(TopLists[type].size()) > MatchSetting.maxLeaderListSize) {TopLists[type].resize(MatchSetting.maxLeaderListSize);}
-    if(static_cast<int>(BottomLists[type].size()) > MatchSetting.maxLeaderListSize) {BottomLists[type].resize(MatchSetting.maxLeaderListSize);}
+    const double value = player.GetStatByTypeForSort(type);
+    const size_t capacity = static_cast<size_t>((std::max)(MatchSetting.maxLeaderListSize, 0));
+    TopLists[type].Report(player.GetId(), value, capacity);
+    BottomLists[type].Report(player.GetId(), value, capacity);
 }
 
-std::vector<VirtualPlayer> MatchMakingSystem::GetSortedPlayerList(EPlayerSortingType type, bool bAscend) const
+TArrayView<int> MatchMakingSystem::GetSortedPlayerList(EPlayerSortingType type, bool bAscend) const
 {
     if (bAscend)
     {
         auto it = BottomLists.find(type);
         if (it != BottomLists.end())
         {
-            return it->second;
+            return it->second.GetIds();
         }
     }
     else
@@ -303,94 +609,144 @@ std::vector<VirtualPlayer> MatchMakingSystem::GetSortedPlayerList(EPlayerSorting
         auto it = TopLists.find(type);
         if (it != TopLists.end())
         {
-            return it->second;
+            return it->second.GetIds();
         }
     }
     return {};
 }
 
+int MatchMakingSystem::GetPlayerRank(EPlayerSortingType type, int playerId) const
+{
+    return rankIndices[type].GetRank(playerId);
+}
+
+double MatchMakingSystem::GetPlayerPercentile(EPlayerSortingType type, int playerId) const
+{
+    return rankIndices[type].GetPercentile(playerId);
+}
+
+void MatchMakingSystem::GetPlayersByRank(EPlayerSortingType type, size_t firstRank, size_t count, std::vector<int>& outIds) const
+{
+    rankIndices[type].GetRange(firstRank, count, outIds);
+}
+
 int MatchMakingSystem::GetNumPlayerOfState(EPlayerState state) const
 {
-    auto it = playerStateMap.find(state);
-    return it == playerStateMap.end()? 0 : it->second;
+    return allPlayers.GetStats().GetNumPlayers(state);
 }
 
 double MatchMakingSystem::GetAvgQueueTime() const
 {
-    if (!allPlayersLookupMap.empty())
-    {
-        double totalQTime = std::accumulate(allPlayersLookupMap.begin(), allPlayersLookupMap.end(), 0.0,
-            [](double total, const std::pair<const int, VirtualPlayer>& entry)
-            {
-                const VirtualPlayer& player = entry.second;
-                return total + player.GetAvgQueueTime();
-            }
-        );
-        return totalQTime / static_cast<double>(allPlayersLookupMap.size());
-    }
-    return 0;
+    return allPlayers.GetStats().GetAvgTimeInState(EPlayerState::InQueue, WorldTime::GetWorldTimeMillis());
+}
+
+double MatchMakingSystem::GetAvgGameTime() const
+{
+    return allPlayers.GetStats().GetAvgTimeInState(EPlayerState::InGame, WorldTime::GetWorldTimeMillis());
+}
+
+double MatchMakingSystem::GetAvgOnlineTime() const
+{
+    // rows parked by overflow keep their past online time but aren't players of this system anymore
+    const int numPlayers = static_cast<int>(allPlayers.size()) - GetNumPlayerOfState(EPlayerState::None);
+    if (numPlayers <= 0) return 0.0;
+    return static_cast<double>(allPlayers.GetStats().GetTotalOnlineTime(WorldTime::GetWorldTimeMillis())) / static_cast<double>(numPlayers);
 }
 
 bool MatchMakingSystem::AddPlayerToQueue(VirtualPlayer* player)
 {
-    if (queuedPlayerIds.find(player->GetId()) != queuedPlayerIds.end())
+    FQueueHandle& handle = player->GetQueueHandle();
+    if (handle.bIsQueued)
     {
         return false;
     }
 
-    queuedPlayerIds.insert(player->GetId());
-    queuedPlayers.push_back(player);
+    handle.bIsQueued = true;
+    queuedPlayers.PushBack(player);
     return true;
 }
 
 void MatchMakingSystem::RemovePlayerFromQueue(VirtualPlayer* player)
 {
-    if (queuedPlayerIds.find(player->GetId()) == queuedPlayerIds.end())
+    FQueueHandle& handle = player->GetQueueHandle();
+    if (!handle.bIsQueued)
     {
         return;  // Player is not in queue
     }
 
-    queuedPlayerIds.erase(player->GetId());  // Remove from tracking set
+    if (handle.poolIndex >= 0)
+    {
+        RemoveFromDraftedPool(player);
+    }
+    else if (handle.poolIndex != FQueueHandle::readyTeam) // a ready team notices the reset handle when it's launched
+    {
+        queuedPlayers.Remove(player);
+    }
+    handle.Reset();
+}
 
-    // Remove player from queue
-    queuedPlayers.erase(std::remove_if(queuedPlayers.begin(), queuedPlayers.end(),
-        [&](VirtualPlayer* p) { return p->GetId() == player->GetId(); }),
-        queuedPlayers.end());
-        
-    for (auto& team : draftedPools)
+void MatchMakingSystem::RemoveFromDraftedPool(VirtualPlayer* player)
+{
+    const FQueueHandle& handle = player->GetQueueHandle();
+    const size_t poolIndex = static_cast<size_t>(handle.poolIndex);
+    std::vector<VirtualPlayer*>& pool = draftedPools[poolIndex];
+
+    // pools hold at most one match worth of players, keep their draft order so teams are split the same way
+    pool.erase(pool.begin() + handle.poolSlot);
+    for (size_t slot = static_cast<size_t>(handle.poolSlot); slot < pool.size(); ++slot)
     {
-        auto it = std::remove(team.begin(), team.end(), player);
-        if (it != team.end())
-        {
-            team.erase(it, team.end());  // Remove player from the team
+        pool[slot]->GetQueueHandle().poolSlot = static_cast<int>(slot);
+    }
 
-            // If the team is now empty, remove it
-            if (team.empty())
-            {
-                team = std::move(draftedPools.back());  // Move last team here
-                draftedPools.pop_back();
-            }
-            return;  // Exit after removal (assuming player is only in one team)
-        }
+    if (pool.empty())
+    {
+        RemoveDraftedPool(poolIndex);
     }
 }
 
+void MatchMakingSystem::RemoveDraftedPool(size_t poolIndex)
+{
+    if (poolIndex + 1 != draftedPools.size())
+    {
+        draftedPools[poolIndex] = std::move(draftedPools.back());
+        for (VirtualPlayer* player : draftedPools[poolIndex])
+        {
+            player->GetQueueHandle().poolIndex = static_cast<int>(poolIndex);
+        }
+    }
+    draftedPools.pop_back();
+}
 
 void MatchMakingSystem::TryAssignPlayerToTeam(VirtualPlayer* player)
 {
     bool bMatchablePoolFound = false;
 
+    FQueueHandle& handle = player->GetQueueHandle();
+    if (handle.bIsQueued && (handle.poolIndex >= 0 || handle.poolIndex == FQueueHandle::readyTeam))
+    {
+        return; // already drafted
+    }
+    if (handle.bIsQueued)
+    {
+        queuedPlayers.Remove(player);
+    }
+
     if (player->GetState() != EPlayerState::InQueue)
     {
-        // if player no longer in queue, skip this step. DraftTeamsFromQueue() function will remove this player from queue
+        // if player no longer in queue, skip this step
+        handle.Reset();
         return;
     }
+    handle.bIsQueued = true;
     
     // Try to fit the player into an existing team
-    for (std::vector<VirtualPlayer*>& team : draftedPools)
+    for (size_t poolIndex = 0; poolIndex < draftedPools.size(); ++poolIndex)
     {
+        std::vector<VirtualPlayer*>& team = draftedPools[poolIndex];
         if (IsPlayerMatchable(*player, team))
         {
+            handle.poolIndex = static_cast<int>(poolIndex);
+            handle.poolSlot = static_cast<int>(team.size());
             team.push_back(player);
             bMatchablePoolFound = true;
             break;
@@ -400,6 +756,8 @@ void MatchMakingSystem::TryAssignPlayerToTeam(VirtualPlayer* player)
     // If no team was found, create a new pool
     if (!bMatchablePoolFound)
     {
+        handle.poolIndex = static_cast<int>(draftedPools.size());
+        handle.poolSlot = 0;
         draftedPools.push_back({player});
     }
 }
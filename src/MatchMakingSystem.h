@@ -1,37 +1,73 @@
 #pragma once
 
 #include <map>
+#include <memory>
 #include <vector>
 #include <queue>
 #include <random>
 #include <set>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <variant>
 
+#include "JobSystem.h"
+#include "LeaderList.h"
+#include "Logger.h"
+#include "MatchArchive.h"
 #include "MM_Elements.h"
+#include "PlayerStore.h"
+#include "RankIndex.h"
+#include "SlotMap.h"
+#include "SpscRing.h"
+#include "TimingWheel.h"
 #include "WorldClock.h"
+#include "Xoshiro256ss.h"
 
 class WorldClock;
 enum class EPlayerState;
 class VirtualPlayer;
 
-struct FPlayersStateEvent
+// scheduled player state changes, keyed by player id so a new schedule replaces the pending one
+using FPlayersStateEventWheel = TTimingWheel<EPlayerState>;
+
+// ongoing match end times, keyed by the match's slot index with the slot generation as payload
+using FMatchEndWheel = TTimingWheel<uint32_t>;
+
+// players waiting to be drafted, linked through their FQueueHandle so any of them can leave in O(1)
+class FPlayerQueue
 {
-    uint64_t time;
-    int playerId;
-    EPlayerState newState;
+public:
+    bool IsEmpty() const { return head == nullptr; }
+    size_t Size() const { return size; }
+    VirtualPlayer* Front() const { return head; }
+    VirtualPlayer* Back() const { return tail; }
 
-    FPlayersStateEvent(uint64_t inTime, int inPlayerId, EPlayerState inState)
-        : time(inTime), playerId(inPlayerId), newState(inState) {}
+    void PushBack(VirtualPlayer* player)
+    {
+        FQueueHandle& handle = player->GetQueueHandle();
+        handle.prev = tail;
+        handle.next = nullptr;
+        if (tail != nullptr) { tail->GetQueueHandle().next = player; } else { head = player; }
+        tail = player;
+        ++size;
+    }
 
-    bool operator>(const FPlayersStateEvent& other) const
+    void Remove(VirtualPlayer* player)
     {
-        return time > other.time;
+        FQueueHandle& handle = player->GetQueueHandle();
+        if (handle.prev != nullptr) { handle.prev->GetQueueHandle().next = handle.next; } else { head = handle.next; }
+        if (handle.next != nullptr) { handle.next->GetQueueHandle().prev = handle.prev; } else { tail = handle.prev; }
+        handle.prev = nullptr;
+        handle.next = nullptr;
+        --size;
     }
-};
 
-inline std::priority_queue<FPlayersStateEvent, std::vector<FPlayersStateEvent>, std::greater<>> playersStateEvent;
+private:
+    VirtualPlayer* head = nullptr;
+    VirtualPlayer* tail = nullptr;
+    size_t size = 0;
+};
 
 // carries settings of the current world. Defines world time and population
 struct FWorldSetting
@@ -39,6 +75,14 @@ struct FWorldSetting
     // World info
     int avgPlayerPerBatch = 25; // only add up to this amount +-50% at a time
     int playerCreationCheckInterval = 15;
+    int eventBudgetMicros = 0; // wall clock time per update for player state events, 0 processes every due event
+    int workerThreads = 1; // job system threads running the update phases, due match ends and shards. Results are the same for any count
+    // drafting and match starts run side by side, full pools reach the launcher through a ring and start one update later
+    bool bPipelinedDraft = false;
+
+    // completed matches kept in memory, older ones go to matchArchiveFile or are dropped when it's empty. 0 keeps all
+    int matchArchiveWindow = 100000;
+    std::string matchArchiveFile;
 };
 
 // carries settings of the Match of the game that's offering the MatchMaking system
@@ -60,6 +104,28 @@ struct FMatchSetting
     int maxSkillGap = 10;
 };
 
+// Running totals of the work the system has done, for throughput reports
+struct FSystemCounters
+{
+    uint64_t stateEventsProcessed = 0;
+    uint64_t matchesStarted = 0;
+    uint64_t matchesCompleted = 0;
+
+    // player state event backlog, only grows when the event budget runs out
+    uint64_t budgetExhaustedUpdates = 0;
+    size_t stateEventBacklog = 0; // due events left unprocessed by the last update
+    size_t peakStateEventBacklog = 0;
+    FValueSummary stateEventLateness; // world millis between the scheduled and the processed time
+    FValueSummary readyTeamWait; // pipelined draft only, world millis between a pool filling up and its match start
+};
+
+// exact distributions behind the summaries of FSystemCounters, too big to copy for every published snapshot
+struct FSystemHistograms
+{
+    FValueHistogram stateEventLateness; // world millis, 1ms buckets
+    FValueHistogram readyTeamWait;
+};
+
 // Types of algorithm of match making, each have a different complexity and can affect the system's efficiency and balance
 enum EMatchMakeAlgorithm
 {
@@ -82,38 +148,72 @@ class MatchMakingSystem
 {
 public:
     MatchMakingSystem(EMatchMakeAlgorithm SelectedAlgorithm);
+    ~MatchMakingSystem();
 
     bool AddPlayerToQueue(VirtualPlayer* player);
     void RemovePlayerFromQueue(VirtualPlayer* player);
     void TryAssignPlayerToTeam(VirtualPlayer* player);
     void Update();
+
+    // earliest world time at which Update() has work to do. Returns the current time if something is already due
+    uint64_t GetNextEventTime() const;
     
     void CreatePlayer();
-    std::vector<VirtualPlayer> GetSortedPlayerList(EPlayerSortingType type, bool bAscend = false) const;
+    // Cross system overflow. Players queued for at least minQueueTime leave this system, their rows stay parked in
+    // EPlayerState::None. Admitted players join the queue right away, a player that was here before gets their parked
+    // row back, so moving back and forth doesn't grow the store
+    void ReleaseLongWaitingPlayers(uint64_t minQueueTime, size_t maxCount, std::vector<FPlayerProfile>& outPlayers);
+    void AdmitPlayers(const std::vector<FPlayerProfile>& players);
+    // home shard of the players created here, see FPlayerProfile::homeShard
+    void SetShardIndex(int index) { shardIndex = index; }
+    // ids of the leader list, best first. Ascending returns the bottom list
+    TArrayView<int> GetSortedPlayerList(EPlayerSortingType type, bool bAscend = false) const;
+    // exact standing in the whole population, rank 0 has the highest value and equal values rank by ascending id
+    int GetPlayerRank(EPlayerSortingType type, int playerId) const;
+    double GetPlayerPercentile(EPlayerSortingType type, int playerId) const;
+    void GetPlayersByRank(EPlayerSortingType type, size_t firstRank, size_t count, std::vector<int>& outIds) const;
     int GetNumPlayerOfState(EPlayerState state) const;
+    // population wide averages from the running totals of FPopulationStats. Queue and game times are the average
+    // length of one queue or match, ongoing ones count up to now. Online time is per player
     double GetAvgQueueTime() const;
+    double GetAvgGameTime() const;
+    double GetAvgOnlineTime() const;
     void AddToPlayerCreationQueue(int count) { playersToCreate += count; }
     
     // Getters and Setters
-    FMatchSetting GetMatchSetting() const { return MatchSetting; }
+    const FMatchSetting& GetMatchSetting() const { return MatchSetting; }
     void SetMatchSetting(const FMatchSetting& Settings) { MatchSetting = Settings; }
-    FWorldSetting GetWorldSetting() const { return WorldSetting; }
-    void SetWorldSetting(const FWorldSetting& Settings) { WorldSetting = Settings; }
-    const std::unordered_set<int>& GetOngoingMatchIds() const { return ongoingMatchIds; }
-    const std::unordered_map<int, VirtualPlayer>& GetAllPlayers() const { return allPlayersLookupMap; }
-    const std::unordered_map<int, FMatch>& GetAllMatches() const { return allMatchesLookupMap; }
-    std::unordered_map<EPlayerState, int> GetPlayerStateMap() const { return playerStateMap; }
-    std::vector<std::vector<VirtualPlayer*>> GetDraftedPools() const { return draftedPools; }
+    const FWorldSetting& GetWorldSetting() const { return WorldSetting; }
+    void SetWorldSetting(const FWorldSetting& Settings);
+    const FPlayerStore& GetAllPlayers() const { return allPlayers; }
+    const TSlotMap<FMatch>& GetOngoingMatches() const { return ongoingMatches; }
+    const FMatchArchive& GetMatchArchive() const { return matchArchive; }
+    // copies an ongoing or archived match into outMatch, false if it isn't available anymore
+    bool FindMatch(int matchId, FMatch& outMatch) const;
+    const std::vector<std::vector<VirtualPlayer*>>& GetDraftedPools() const { return draftedPools; }
+    const FSystemCounters& GetCounters() const { return counters; }
+    const FSystemHistograms& GetHistograms() const { return histograms; }
+    // shares another system's job system, e.g. the one of the FShardCoordinator. nullptr goes back to the own one
+    void SetJobSystem(FJobSystem* sharedJobSystem);
+    const FJobSystem& GetJobSystem() const { return *jobSystem; }
 
 private:
+    friend struct FMatchMakingBenchAccess; // benchmarks drive the private update phases directly
+
     void Update_DraftQueuedPlayers(); // interval in millisecond
     void Update_StartMatchFromQueuedPools();
+    // pipelined stages, the drafter hands full pools to the launcher through readyTeams
+    void Update_DraftStage();
+    void Update_LaunchStage();
+    void RequeueReturnedPlayers();
     void Update_Matches();
     void Update_PlayerRoutine();
     void Update_CheckPlayerCreation();
 
-    // try to start a match with a drafted team, returns the list of players actually joined
-    std::vector<VirtualPlayer*> StartMatch(const std::vector<VirtualPlayer*>& draftedTeam);
+    void RegisterNewPlayer(const VirtualPlayer& player); // leader lists and rank indices
+
+    // try to start a match with a drafted team, returns an invalid handle if nobody joined
+    FMatchHandle StartMatch(const std::vector<VirtualPlayer*>& draftedTeam);
     bool IsPlayerMatchable(const VirtualPlayer& player, std::vector<VirtualPlayer*> draftedPool) const;
 
     void OnPlayerStateChange(VirtualPlayer* player, EPlayerState oldState, EPlayerState newState);
@@ -122,27 +222,71 @@ private:
     FWorldSetting WorldSetting;
     FMatchSetting MatchSetting;
     EMatchMakeAlgorithm algorithm;
+    FSystemCounters counters;
+    FSystemHistograms histograms;
+    int stateChangeListenerHandle = 0;
+    int shardIndex = 0;
+    std::unordered_map<uint64_t, int> admittedRows; // row of every player admitted from another shard, by home shard and id
 
     // All ref data cache
-    std::unordered_map<int, VirtualPlayer> allPlayersLookupMap;
-    std::unordered_map<int, FMatch> allMatchesLookupMap;
+    FPlayerStore allPlayers;
+    TSlotMap<FMatch> ongoingMatches;
+    std::unordered_map<int, FMatchHandle> ongoingMatchHandles; // by match id, for FindMatch
+    FMatchEndWheel matchEndEvents;
+    std::vector<FMatchEndWheel::FEntry> dueMatchEnds; // reused extraction buffer
+    struct FEndingMatch
+    {
+        FMatchHandle handle;
+        FMatch* match = nullptr; // invalid once the first ending match is removed from ongoingMatches
+        int matchId = -1;
+        float winnerRoll = 0.0f;
+    };
+    std::vector<FEndingMatch> endingMatches; // due matches of the current update, in end time order
+    static constexpr size_t minMatchesPerChunk = 32; // fewer due matches than this end on the calling thread
+    FMatchArchive matchArchive; // completed matches
+
+    // Update() runs the phases as a graph, their timings show which one limits the scaling
+    FJobGraph updateGraph;
+    FJobGraph pipelinedUpdateGraph; // FWorldSetting::bPipelinedDraft, the draft and launch stages run concurrently
+    std::unique_ptr<FJobSystem> ownedJobSystem; // sized by FWorldSetting::workerThreads, null while a shared one is set
+    FJobSystem* jobSystem = nullptr;
+    Xoshiro256SS updateRandom; // the calling thread's generator while the phases run
+    int nextMatchId = 0;
     
     // smaller data cache, for faster cache that changes a lot
-    std::unordered_set<int> ongoingMatchIds;
-    std::unordered_map<EPlayerState, int> playerStateMap;
     std::vector<std::vector<VirtualPlayer*>> draftedPools;
+    static constexpr size_t maxDraftablePools = 100;
+
+    // pipelined draft, a full pool keeps its players InQueue until the launcher starts its match
+    struct FReadyTeam
+    {
+        std::vector<VirtualPlayer*> players;
+        uint64_t readyTime = 0; // world time the pool filled up
+        int ticket = 0; // poolSlot of the players that are still waiting for this team
+    };
+    TSpscRing<FReadyTeam> readyTeams{maxDraftablePools}; // never full, ready teams count towards maxDraftablePools
+    size_t readyTeamsAtUpdateStart = 0; // only these are launched, so the result doesn't depend on which stage runs first
+    int nextTeamTicket = 0;
+    std::vector<VirtualPlayer*> returnedPlayers; // left over from teams that lost a player, queued again by the next update
     
+    // future player state changes, at most one per player
+    FPlayersStateEventWheel playersStateEvents;
+    std::vector<FPlayersStateEventWheel::FEntry> dueStateEvents; // reused extraction buffer
+    static constexpr size_t eventBatchSize = 64; // events processed between budget checks
+
     // delay time caches
     uint64_t lastPoolCheckTime = 0;
     uint64_t lastPlayerCreationCheckTime = 0;
 
     // Cached lists for Display
-    std::map<EPlayerSortingType, std::vector<VirtualPlayer>> TopLists;
-    std::map<EPlayerSortingType, std::vector<VirtualPlayer>> BottomLists;
+    std::map<EPlayerSortingType, FLeaderList> TopLists;
+    std::map<EPlayerSortingType, FLeaderList> BottomLists;
+    std::vector<FStatRankIndex> rankIndices; // indexed by EPlayerSortingType
     void ReportToLeaderLists(EPlayerSortingType type, const VirtualPlayer& player);
     
-    std::deque<VirtualPlayer*> queuedPlayers;
-    std::unordered_set<int> queuedPlayerIds; // additional int array to manage existing player lookup
+    FPlayerQueue queuedPlayers; // queued players that are not drafted into a pool yet
+    void RemoveFromDraftedPool(VirtualPlayer* player);
+    void RemoveDraftedPool(size_t poolIndex); // swaps the last pool into its place
 
     // remaining players waiting to be created, this is more of a simulation trait, mimicking players creating their account for the game.
     // also serves as a queue to prevent adding thousands of players at a time
@@ -0,0 +1,265 @@
+#pragma once
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "MM_Elements.h"
+
+// Per player data read or written on every state change, event or population scan. One packed array per field
+struct FPlayerHotColumns
+{
+    std::vector<EPlayerState> state;
+    std::vector<uint64_t> stateChangeTimeStamp; // time when last state changed. Use this to record player activity history
+    std::vector<uint64_t> currentIdleTime; // idle time: time when player stays online but not in queue
+    std::vector<uint64_t> totalOnlineTime;
+    std::vector<FMatchHandle> ongoingMatch;
+    std::vector<EPlayerTrait> traits; // Supports multiple traits through bitmask
+
+    // Quantified play style
+    std::vector<int> agr; // Aggressiveness - Willingness to take risks and engage in high-pressure plays
+    std::vector<int> fle; // Flexibility - Ability to adapt to new strategies and opponents
+    std::vector<int> gri; // Grit - Mental resilience and ability to recover from set-bakcs
+    std::vector<int> edr; // Endurance - Long-term consistency across multiple matches
+    std::vector<int> ins; // Instinct - Quick and accurate decision-making under pressure
+    std::vector<int> cre; // Creativity - Likelihood of turning the tide unexpectedly; wildcard behavior
+    std::vector<int> pre; // Precision - Ability to execute mechanical actions with accuracy and efficiency
+
+    // results and time accumulators
+    std::vector<int> wonCount;
+    std::vector<int> lostCount;
+    std::vector<float> winRate;
+    std::vector<int> queueCount;
+    std::vector<uint64_t> queueTimeTotal;
+    std::vector<int> gameCount;
+    std::vector<uint64_t> gameTimeTotal;
+
+    std::vector<FQueueHandle> queueHandle;
+
+    void Add()
+    {
+        state.push_back(EPlayerState::None);
+        stateChangeTimeStamp.push_back(0);
+        currentIdleTime.push_back(0);
+        totalOnlineTime.push_back(0);
+        ongoingMatch.emplace_back();
+        traits.push_back(EPlayerTrait::None);
+        agr.push_back(0);
+        fle.push_back(0);
+        gri.push_back(0);
+        edr.push_back(0);
+        ins.push_back(0);
+        cre.push_back(0);
+        pre.push_back(0);
+        wonCount.push_back(0);
+        lostCount.push_back(0);
+        winRate.push_back(0.0f);
+        queueCount.push_back(0);
+        queueTimeTotal.push_back(0);
+        gameCount.push_back(0);
+        gameTimeTotal.push_back(0);
+        queueHandle.emplace_back();
+    }
+};
+
+// Per player data that is only read for display or grows over time, kept away from the hot columns
+struct FPlayerColdData
+{
+    std::vector<int> matchHistory;
+    std::vector<int> wonMatches;
+    std::vector<int> lostMatches;
+    std::vector<std::pair<uint64_t, uint64_t>> desiredOnlineTimes;
+    FActivityLog activityLog;
+    int homeShard = -1; // FPlayerProfile home of a player admitted from another shard
+    int homeId = -1;
+};
+
+// Running totals over the whole population, updated on every state change so population wide averages are O(1).
+// Time spent in a state is split into finished stints and the ongoing ones, which are worked out from the sum of the
+// times the current players entered the state
+class FPopulationStats
+{
+public:
+    static constexpr int NUM_STATES = static_cast<int>(EPlayerState::IterationRef);
+    static constexpr int HOURS_PER_DAY = 24;
+
+    void OnPlayerAdded(uint64_t enteredAt)
+    {
+        FStateTotals& totals = states[static_cast<int>(EPlayerState::None)];
+        ++totals.playerCount;
+        totals.enteredAtSum += enteredAt;
+    }
+
+    void OnStateChange(EPlayerState oldState, EPlayerState newState, uint64_t enteredAt, uint64_t now)
+    {
+        FStateTotals& oldTotals = states[static_cast<int>(oldState)];
+        --oldTotals.playerCount;
+        oldTotals.enteredAtSum -= enteredAt;
+        ++oldTotals.finishedStints;
+        oldTotals.finishedTime += now - enteredAt;
+
+        const int hour = static_cast<int>((now % WorldTime::MILLISENCONDS_PER_DAY) / WorldTime::MILLISENCONDS_PER_HOUR);
+        ++finishedStintsByHour[static_cast<int>(oldState)][hour];
+        finishedTimeByHour[static_cast<int>(oldState)][hour] += now - enteredAt;
+
+        FStateTotals& newTotals = states[static_cast<int>(newState)];
+        ++newTotals.playerCount;
+        newTotals.enteredAtSum += now;
+    }
+
+    int GetNumPlayers(EPlayerState state) const { return states[static_cast<int>(state)].playerCount; }
+    // finished stints plus the ongoing ones, the divisor of GetAvgTimeInState
+    uint64_t GetNumStints(EPlayerState state) const { return states[static_cast<int>(state)].finishedStints + static_cast<uint64_t>(states[static_cast<int>(state)].playerCount); }
+
+    // time all players spent in the state, ongoing stints count up to now
+    uint64_t GetTotalTimeInState(EPlayerState state, uint64_t now) const
+    {
+        const FStateTotals& totals = states[static_cast<int>(state)];
+        return totals.finishedTime + static_cast<uint64_t>(totals.playerCount) * now - totals.enteredAtSum;
+    }
+
+    // average length of one stint in the state, ongoing stints count as if they ended now
+    double GetAvgTimeInState(EPlayerState state, uint64_t now) const
+    {
+        const uint64_t stints = GetNumStints(state);
+        return stints == 0 ? 0.0 : static_cast<double>(GetTotalTimeInState(state, now)) / static_cast<double>(stints);
+    }
+
+    // average length of the finished stints that ended in this hour of the day
+    double GetAvgTimeInStateByHour(EPlayerState state, int hour) const
+    {
+        const uint64_t stints = finishedStintsByHour[static_cast<int>(state)][hour];
+        return stints == 0 ? 0.0 : static_cast<double>(finishedTimeByHour[static_cast<int>(state)][hour]) / static_cast<double>(stints);
+    }
+
+    uint64_t GetFinishedStintsByHour(EPlayerState state, int hour) const { return finishedStintsByHour[static_cast<int>(state)][hour]; }
+
+    // every state but None, Offline and Disconnected counts as online, same as VirtualPlayer::GetOnlineTime
+    uint64_t GetTotalOnlineTime(uint64_t now) const
+    {
+        uint64_t total = 0;
+        for (int i = 0; i < NUM_STATES; ++i)
+        {
+            const EPlayerState state = static_cast<EPlayerState>(i);
+            if (state != EPlayerState::None && state != EPlayerState::Offline && state != EPlayerState::Disconnected)
+            {
+                total += GetTotalTimeInState(state, now);
+            }
+        }
+        return total;
+    }
+
+private:
+    struct FStateTotals
+    {
+        int playerCount = 0;
+        uint64_t enteredAtSum = 0; // sum of the times the current players entered the state
+        uint64_t finishedStints = 0;
+        uint64_t finishedTime = 0;
+    };
+
+    FStateTotals states[NUM_STATES];
+    uint64_t finishedStintsByHour[NUM_STATES][HOURS_PER_DAY] = {};
+    uint64_t finishedTimeByHour[NUM_STATES][HOURS_PER_DAY] = {};
+};
+
+// All players of a MatchMakingSystem, indexed directly by id.
+// Ids are handed out sequentially so the store stays dense. Hot fields are stored as columns so scans stream through
+// packed arrays, cold data sits in a side table. The VirtualPlayer handles live in a std::deque so pointers to them
+// stay valid while the store grows.
+class FPlayerStore
+{
+public:
+    using iterator = std::deque<VirtualPlayer>::iterator;
+    using const_iterator = std::deque<VirtualPlayer>::const_iterator;
+
+    FPlayerStore() = default;
+    FPlayerStore(const FPlayerStore&) = delete; // handles point back at the store
+    FPlayerStore& operator=(const FPlayerStore&) = delete;
+
+    // creates a player with the next free id and randomized traits
+    VirtualPlayer& Create()
+    {
+        VirtualPlayer& player = AddPlayer();
+        player.Initialize();
+        return player;
+    }
+
+    VirtualPlayer& Create(EPlayerTrait traits)
+    {
+        VirtualPlayer& player = AddPlayer();
+        player.Initialize(traits);
+        return player;
+    }
+
+    VirtualPlayer& Create(const FPlayerProfile& profile)
+    {
+        VirtualPlayer& player = AddPlayer();
+        player.Initialize(profile);
+        return player;
+    }
+
+    bool IsValidId(int id) const { return id >= 0 && id < static_cast<int>(players.size()); }
+    VirtualPlayer* Find(int id) { return IsValidId(id) ? &players[id] : nullptr; }
+    const VirtualPlayer* Find(int id) const { return IsValidId(id) ? &players[id] : nullptr; }
+    VirtualPlayer& operator[](int id) { return players[id]; }
+    const VirtualPlayer& operator[](int id) const { return players[id]; }
+
+    // container style access so the store can be used in range for and std algorithms
+    size_t size() const { return players.size(); }
+    bool empty() const { return players.empty(); }
+    iterator begin() { return players.begin(); }
+    iterator end() { return players.end(); }
+    const_iterator begin() const { return players.begin(); }
+    const_iterator end() const { return players.end(); }
+
+    // column access for linear scans over the whole population
+    const FPlayerHotColumns& GetHotColumns() const { return hot; }
+    const FPopulationStats& GetStats() const { return stats; }
+
+private:
+    friend class VirtualPlayer;
+
+    std::deque<VirtualPlayer> players;
+    FPlayerHotColumns hot;
+    std::vector<FPlayerColdData> cold;
+    FPopulationStats stats;
+
+    VirtualPlayer& AddPlayer()
+    {
+        hot.Add();
+        stats.OnPlayerAdded(hot.stateChangeTimeStamp.back());
+        cold.emplace_back();
+        players.emplace_back(this, static_cast<int>(players.size()));
+        return players.back();
+    }
+};
+
+// ===== VIRTUAL PLAYER ACCESSORS BEGIN =====
+
+inline uint64_t VirtualPlayer::GetOnlineTime() const { return store->hot.totalOnlineTime[id]; }
+inline int VirtualPlayer::GetTotalMatchesPlayed() const { return store->hot.wonCount[id] + store->hot.lostCount[id]; }
+inline EPlayerState VirtualPlayer::GetState() const { return store->hot.state[id]; }
+inline const std::vector<int>& VirtualPlayer::GetWonMatches() const { return store->cold[id].wonMatches; }
+inline const std::vector<int>& VirtualPlayer::GetLostMatches() const { return store->cold[id].lostMatches; }
+inline const std::vector<int>& VirtualPlayer::GetMatchHistory() const { return store->cold[id].matchHistory; }
+inline FMatchHandle VirtualPlayer::GetOngoingMatch() const { return store->hot.ongoingMatch[id]; }
+inline void VirtualPlayer::SetOngoingMatch(FMatchHandle handle) { store->hot.ongoingMatch[id] = handle; }
+inline double VirtualPlayer::GetWinRate() const { return store->hot.winRate[id]; }
+inline int VirtualPlayer::GetAgr() const { return store->hot.agr[id]; }
+inline int VirtualPlayer::GetFle() const { return store->hot.fle[id]; }
+inline int VirtualPlayer::GetGri() const { return store->hot.gri[id]; }
+inline int VirtualPlayer::GetEdr() const { return store->hot.edr[id]; }
+inline int VirtualPlayer::GetIns() const { return store->hot.ins[id]; }
+inline int VirtualPlayer::GetCre() const { return store->hot.cre[id]; }
+inline int VirtualPlayer::GetPre() const { return store->hot.pre[id]; }
+inline const std::vector<std::pair<uint64_t, uint64_t>>& VirtualPlayer::GetDesiredOnlineTimes() const { return store->cold[id].desiredOnlineTimes; }
+inline uint64_t VirtualPlayer::GetCurrentIdleTime() const { return store->hot.currentIdleTime[id]; }
+inline const FActivityLog& VirtualPlayer::GetActivityLog() const { return store->cold[id].activityLog; }
+inline FQueueHandle& VirtualPlayer::GetQueueHandle() { return store->hot.queueHandle[id]; }
+inline const FQueueHandle& VirtualPlayer::GetQueueHandle() const { return store->hot.queueHandle[id]; }
+inline EPlayerTrait VirtualPlayer::GetTraits() const { return store->hot.traits[id]; }
+inline void VirtualPlayer::AddTrait(EPlayerTrait newTrait) { store->hot.traits[id] |= newTrait; }
+inline void VirtualPlayer::RemoveTrait(EPlayerTrait traitToRemove) { store->hot.traits[id] = store->hot.traits[id] & ~traitToRemove; }
+
+// ===== VIRTUAL PLAYER ACCESSORS END =====
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/*
+ * Exact rank index of the whole population for one stat.
+ * Players are ordered by value, highest first, and equal values by ascending id, so every player has exactly one rank
+ * and a page of ranks only changes when a value in it did. The order is kept in sorted blocks of a few hundred
+ * players, a Fenwick tree counts the players per block so the number of players ranked before a block is a prefix
+ * sum. Updates, rank and percentile queries are O(log n) plus a short move inside one block.
+ * Values are stored as float, the ranked stats are ints and the float win rate, so they compare exactly.
+ */
+class FStatRankIndex
+{
+public:
+    // inserts the player or moves it to the position of the new value
+    void Set(int playerId, double value)
+    {
+        if (playerId >= static_cast<int>(playerValues.size()))
+        {
+            playerValues.resize(playerId + 1, 0.0f);
+            bIsIndexed.resize(playerId + 1, false);
+        }
+
+        const float storedValue = static_cast<float>(value);
+        if (bIsIndexed[playerId])
+        {
+            if (playerValues[playerId] == storedValue) return;
+            Erase(MakeKey(playerValues[playerId], playerId));
+        }
+        playerValues[playerId] = storedValue;
+        bIsIndexed[playerId] = true;
+        Insert(MakeKey(storedValue, playerId));
+    }
+
+    void Remove(int playerId)
+    {
+        if (!Contains(playerId)) return;
+        Erase(MakeKey(playerValues[playerId], playerId));
+        bIsIndexed[playerId] = false;
+    }
+
+    bool Contains(int playerId) const { return playerId >= 0 && playerId < static_cast<int>(bIsIndexed.size()) && bIsIndexed[playerId]; }
+    size_t Size() const { return count; }
+
+    // 0 is the highest value, -1 if the player isn't indexed
+    int GetRank(int playerId) const
+    {
+        if (!Contains(playerId)) return -1;
+        return static_cast<int>(CountBefore(MakeKey(playerValues[playerId], playerId)));
+    }
+
+    // share of the population with a strictly lower value, 0 for the lowest and approaching 1 for the highest
+    double GetPercentile(int playerId) const
+    {
+        if (!Contains(playerId)) return 0.0;
+        // ranks behind the last player that could have this value
+        const size_t higherOrEqual = CountBefore(MakeKey(playerValues[playerId], UINT32_MAX));
+        return static_cast<double>(count - higherOrEqual) / static_cast<double>(count);
+    }
+
+    // ids of the players at ranks [firstRank, firstRank + maxCount), highest value first. Replaces the content of ids
+    void GetRange(size_t firstRank, size_t maxCount, std::vector<int>& ids) const
+    {
+        ids.clear();
+        const size_t lastRank = firstRank + maxCount < count ? firstRank + maxCount : count;
+        if (firstRank >= lastRank) return;
+
+        ids.reserve(lastRank - firstRank);
+        size_t block = FindBlockOfRank(firstRank);
+        size_t slot = firstRank - CountBlocksBefore(block);
+        for (size_t rank = firstRank; rank < lastRank; ++rank, ++slot)
+        {
+            if (slot == blocks[block].size())
+            {
+                ++block;
+                slot = 0;
+            }
+            ids.push_back(static_cast<int>(blocks[block][slot] & UINT32_MAX));
+        }
+    }
+
+private:
+    static constexpr size_t MAX_BLOCK_SIZE = 512; // split in halves above this
+    static constexpr size_t MIN_BLOCK_SIZE = 64; // merged with or refilled from the next block below this
+
+    // rank order as one integer: the value's bits flipped so higher values sort first, then the id
+    using FKey = uint64_t;
+    static FKey MakeKey(float value, uint32_t id)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        bits = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u); // ascending with the value
+        return (static_cast<FKey>(~bits) << 32) | id;
+    }
+
+    std::vector<std::vector<FKey>> blocks; // in rank order, none of them empty
+    std::vector<FKey> blockLasts; // last key of every block, searched without touching the blocks
+    std::vector<int> tree; // Fenwick tree of block sizes, 1 based
+    std::vector<float> playerValues; // indexed by player id
+    std::vector<bool> bIsIndexed;
+    size_t count = 0;
+
+    // first block whose last key doesn't rank before the key, blocks.size() if every block does
+    size_t FindBlock(FKey key) const
+    {
+        return static_cast<size_t>(std::lower_bound(blockLasts.begin(), blockLasts.end(), key) - blockLasts.begin());
+    }
+
+    // keys ranked before this one, whether it's indexed or not
+    size_t CountBefore(FKey key) const
+    {
+        const size_t block = FindBlock(key);
+        if (block == blocks.size()) return count;
+        auto slot = std::lower_bound(blocks[block].begin(), blocks[block].end(), key);
+        return CountBlocksBefore(block) + static_cast<size_t>(slot - blocks[block].begin());
+    }
+
+    void Insert(FKey key)
+    {
+        ++count;
+        if (blocks.empty())
+        {
+            blocks.push_back({key});
+            blockLasts.push_back(key);
+            RebuildTree();
+            return;
+        }
+
+        // past the last block goes to the end of the last block
+        const size_t block = (std::min)(FindBlock(key), blocks.size() - 1);
+        std::vector<FKey>& entries = blocks[block];
+        entries.insert(std::lower_bound(entries.begin(), entries.end(), key), key);
+        if (entries.size() <= MAX_BLOCK_SIZE)
+        {
+            blockLasts[block] = entries.back();
+            AddToTree(block, 1);
+            return;
+        }
+
+        std::vector<FKey> upperHalf(entries.begin() + entries.size() / 2, entries.end());
+        entries.resize(entries.size() / 2);
+        blockLasts[block] = entries.back();
+        blockLasts.insert(blockLasts.begin() + block + 1, upperHalf.back());
+        blocks.insert(blocks.begin() + block + 1, std::move(upperHalf));
+        RebuildTree();
+    }
+
+    void Erase(FKey key)
+    {
+        --count;
+        const size_t block = FindBlock(key);
+        std::vector<FKey>& entries = blocks[block];
+        entries.erase(std::lower_bound(entries.begin(), entries.end(), key));
+        const bool bHasNext = block + 1 < blocks.size();
+        if (!entries.empty() && (entries.size() >= MIN_BLOCK_SIZE || !bHasNext))
+        {
+            blockLasts[block] = entries.back();
+            AddToTree(block, -1);
+            return;
+        }
+
+        // too full to merge: take the front of the next block until both are even, the layout stays the same
+        if (bHasNext && entries.size() + blocks[block + 1].size() > MAX_BLOCK_SIZE)
+        {
+            std::vector<FKey>& next = blocks[block + 1];
+            const size_t moved = (next.size() - entries.size()) / 2;
+            entries.insert(entries.end(), next.begin(), next.begin() + moved);
+            next.erase(next.begin(), next.begin() + moved);
+            blockLasts[block] = entries.back();
+            AddToTree(block, static_cast<int>(moved) - 1);
+            AddToTree(block + 1, -static_cast<int>(moved));
+            return;
+        }
+
+        if (bHasNext)
+        {
+            entries.insert(entries.end(), blocks[block + 1].begin(), blocks[block + 1].end());
+            blocks.erase(blocks.begin() + block + 1);
+            blockLasts.erase(blockLasts.begin() + block + 1);
+            blockLasts[block] = entries.back();
+        }
+        else
+        {
+            blocks.erase(blocks.begin() + block);
+            blockLasts.erase(blockLasts.begin() + block);
+        }
+        RebuildTree();
+    }
+
+    // after blocks were split, merged or removed
+    void RebuildTree()
+    {
+        tree.assign(blocks.size() + 1, 0);
+        for (size_t i = 1; i < tree.size(); ++i)
+        {
+            tree[i] += static_cast<int>(blocks[i - 1].size());
+            const size_t parent = i + (i & (~i + 1));
+            if (parent < tree.size()) { tree[parent] += tree[i]; }
+        }
+    }
+
+    void AddToTree(size_t block, int delta)
+    {
+        for (size_t i = block + 1; i < tree.size(); i += i & (~i + 1))
+        {
+            tree[i] += delta;
+        }
+    }
+
+    // players in the blocks before this one
+    size_t CountBlocksBefore(size_t block) const
+    {
+        int sum = 0;
+        for (size_t i = block; i > 0; i -= i & (~i + 1))
+        {
+            sum += tree[i];
+        }
+        return static_cast<size_t>(sum);
+    }
+
+    // block holding the player at this rank, rank must be below Size()
+    size_t FindBlockOfRank(size_t rank) const
+    {
+        size_t position = 0;
+        int remaining = static_cast<int>(rank);
+        size_t step = 1;
+        while (step * 2 < tree.size()) { step *= 2; }
+        for (; step > 0; step /= 2)
+        {
+            if (position + step < tree.size() && tree[position + step] <= remaining)
+            {
+                position += step;
+                remaining -= tree[position];
+            }
+        }
+        return position; // 'position' blocks hold at most 'rank' players, so the rank falls in the next one
+    }
+};
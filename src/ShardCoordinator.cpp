@@ -0,0 +1,247 @@
+#include "ShardCoordinator.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include "RandomGenerator.h"
+#include "WorldClock.h"
+
+FShardCoordinator::FShardCoordinator(const FShardSetting& inSetting, EMatchMakeAlgorithm algorithm, uint64_t seed)
+    : setting(inSetting)
+{
+    setting.numShards = (std::max)(setting.numShards, 1);
+    shardRandomStates.resize(setting.numShards);
+    shardCounters.resize(setting.numShards);
+    jobSystem = std::make_unique<FJobSystem>(1);
+    for (int i = 0; i < setting.numShards; ++i)
+    {
+        // shard 0 draws the same numbers a single system seeded with seed would
+        shardRandomStates[i].Seed(seed + static_cast<uint64_t>(i));
+        FScopedRandomGenerator scopedRandom(shardRandomStates[i]);
+        shards.push_back(std::make_unique<MatchMakingSystem>(algorithm));
+        shards.back()->SetJobSystem(jobSystem.get());
+        shards.back()->SetShardIndex(i);
+    }
+    worldSetting = shards[0]->GetWorldSetting();
+    matchSetting = shards[0]->GetMatchSetting();
+}
+
+void FShardCoordinator::SetWorldSetting(const FWorldSetting& inSetting)
+{
+    worldSetting = inSetting;
+
+    const int numThreads = (std::max)(worldSetting.workerThreads, 1);
+    const bool bNewJobSystem = numThreads != jobSystem->GetNumThreads();
+    if (bNewJobSystem)
+    {
+        jobSystem = std::make_unique<FJobSystem>(numThreads);
+        jobSystem->SetTimingEnabled(bTaskTiming);
+    }
+
+    for (int i = 0; i < GetNumShards(); ++i)
+    {
+        FWorldSetting shardSetting = worldSetting;
+        if (GetNumShards() > 1 && !shardSetting.matchArchiveFile.empty())
+        {
+            shardSetting.matchArchiveFile += "." + std::to_string(i);
+        }
+        if (bNewJobSystem)
+        {
+            shards[i]->SetJobSystem(jobSystem.get());
+        }
+        shards[i]->SetWorldSetting(shardSetting);
+    }
+}
+
+void FShardCoordinator::SetTaskTimingEnabled(bool bEnabled)
+{
+    bTaskTiming = bEnabled;
+    jobSystem->SetTimingEnabled(bEnabled);
+}
+
+void FShardCoordinator::SetMatchSetting(const FMatchSetting& inSetting)
+{
+    matchSetting = inSetting;
+    for (std::unique_ptr<MatchMakingSystem>& shard : shards)
+    {
+        shard->SetMatchSetting(matchSetting);
+    }
+}
+
+void FShardCoordinator::AddToPlayerCreationQueue(int count)
+{
+    std::vector<float> weights = setting.regionWeights;
+    if (weights.size() != shards.size() || std::accumulate(weights.begin(), weights.end(), 0.0f) <= 0.0f)
+    {
+        weights.assign(shards.size(), 1.0f);
+    }
+    const float totalWeight = std::accumulate(weights.begin(), weights.end(), 0.0f);
+
+    // rounded down per shard, the leftover players go one each to the first shards
+    int assigned = 0;
+    std::vector<int> counts(shards.size());
+    for (size_t i = 0; i < shards.size(); ++i)
+    {
+        counts[i] = static_cast<int>(static_cast<float>(count) * (std::max)(weights[i], 0.0f) / totalWeight);
+        assigned += counts[i];
+    }
+    for (size_t i = 0; assigned < count; i = (i + 1) % shards.size())
+    {
+        ++counts[i];
+        ++assigned;
+    }
+
+    for (size_t i = 0; i < shards.size(); ++i)
+    {
+        shards[i]->AddToPlayerCreationQueue(counts[i]);
+    }
+}
+
+void FShardCoordinator::Update()
+{
+    auto updateShards = [this](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            FScopedRandomGenerator scopedRandom(shardRandomStates[i]);
+            shards[i]->Update();
+        }
+    };
+    jobSystem->ParallelFor("Shards", shards.size(), 1, updateShards);
+
+    Update_Overflow();
+}
+
+void FShardCoordinator::Update_Overflow()
+{
+    if (setting.overflowWaitMillis == 0 || shards.size() < 2) return;
+
+    const uint64_t now = WorldTime::GetWorldTimeMillis();
+    if (now < nextOverflowCheckTime) return;
+    nextOverflowCheckTime = now + static_cast<uint64_t>((std::max)(setting.overflowCheckInterval, 1));
+
+    for (int source = 0; source < GetNumShards(); ++source)
+    {
+        overflowPlayers.clear();
+        {
+            FScopedRandomGenerator scopedRandom(shardRandomStates[source]);
+            shards[source]->ReleaseLongWaitingPlayers(setting.overflowWaitMillis, static_cast<size_t>((std::max)(setting.maxOverflowPerCheck, 0)), overflowPlayers);
+        }
+        if (overflowPlayers.empty()) continue;
+
+        // the shard with the most players queued is the most likely to fill a team with them
+        int target = -1;
+        for (int i = 0; i < GetNumShards(); ++i)
+        {
+            if (i != source && (target < 0 || shards[i]->GetNumPlayerOfState(EPlayerState::InQueue) > shards[target]->GetNumPlayerOfState(EPlayerState::InQueue)))
+            {
+                target = i;
+            }
+        }
+
+        FScopedRandomGenerator scopedRandom(shardRandomStates[target]);
+        shards[target]->AdmitPlayers(overflowPlayers);
+        shardCounters[source].playersSentOut += overflowPlayers.size();
+        shardCounters[target].playersReceived += overflowPlayers.size();
+    }
+}
+
+uint64_t FShardCoordinator::GetNextEventTime() const
+{
+    uint64_t nextEventTime = UINT64_MAX;
+    for (const std::unique_ptr<MatchMakingSystem>& shard : shards)
+    {
+        nextEventTime = (std::min)(nextEventTime, shard->GetNextEventTime());
+    }
+    if (setting.overflowWaitMillis > 0 && shards.size() > 1)
+    {
+        nextEventTime = (std::min)(nextEventTime, (std::max)(nextOverflowCheckTime, WorldTime::GetWorldTimeMillis()));
+    }
+    return nextEventTime;
+}
+
+int FShardCoordinator::GetNumActivePlayers() const
+{
+    int total = 0;
+    for (const std::unique_ptr<MatchMakingSystem>& shard : shards)
+    {
+        total += static_cast<int>(shard->GetAllPlayers().size()) - shard->GetNumPlayerOfState(EPlayerState::None);
+    }
+    return total;
+}
+
+int FShardCoordinator::GetNumPlayerOfState(EPlayerState state) const
+{
+    int total = 0;
+    for (const std::unique_ptr<MatchMakingSystem>& shard : shards)
+    {
+        total += shard->GetNumPlayerOfState(state);
+    }
+    return total;
+}
+
+double FShardCoordinator::GetAvgTimeInState(EPlayerState state) const
+{
+    const uint64_t now = WorldTime::GetWorldTimeMillis();
+    uint64_t totalTime = 0;
+    uint64_t stints = 0;
+    for (const std::unique_ptr<MatchMakingSystem>& shard : shards)
+    {
+        totalTime += shard->GetAllPlayers().GetStats().GetTotalTimeInState(state, now);
+        stints += shard->GetAllPlayers().GetStats().GetNumStints(state);
+    }
+    return stints == 0 ? 0.0 : static_cast<double>(totalTime) / static_cast<double>(stints);
+}
+
+double FShardCoordinator::GetAvgOnlineTime() const
+{
+    const int numPlayers = GetNumActivePlayers();
+    if (numPlayers == 0) return 0.0;
+
+    uint64_t totalTime = 0;
+    for (const std::unique_ptr<MatchMakingSystem>& shard : shards)
+    {
+        totalTime += shard->GetAllPlayers().GetStats().GetTotalOnlineTime(WorldTime::GetWorldTimeMillis());
+    }
+    return static_cast<double>(totalTime) / static_cast<double>(numPlayers);
+}
+
+double FShardCoordinator::GetAvgTimeInStateByHour(EPlayerState state, int hour) const
+{
+    double totalTime = 0.0;
+    uint64_t stints = 0;
+    for (const std::unique_ptr<MatchMakingSystem>& shard : shards)
+    {
+        const FPopulationStats& stats = shard->GetAllPlayers().GetStats();
+        totalTime += stats.GetAvgTimeInStateByHour(state, hour) * static_cast<double>(stats.GetFinishedStintsByHour(state, hour));
+        stints += stats.GetFinishedStintsByHour(state, hour);
+    }
+    return stints == 0 ? 0.0 : totalTime / static_cast<double>(stints);
+}
+
+void FShardCoordinator::GetCounters(FSystemCounters& outCounters) const
+{
+    outCounters = shards[0]->GetCounters();
+    for (size_t i = 1; i < shards.size(); ++i)
+    {
+        const FSystemCounters& counters = shards[i]->GetCounters();
+        outCounters.stateEventsProcessed += counters.stateEventsProcessed;
+        outCounters.matchesStarted += counters.matchesStarted;
+        outCounters.matchesCompleted += counters.matchesCompleted;
+        outCounters.budgetExhaustedUpdates += counters.budgetExhaustedUpdates;
+        outCounters.stateEventBacklog += counters.stateEventBacklog;
+        outCounters.peakStateEventBacklog += counters.peakStateEventBacklog; // upper bound, the shards peak at different times
+        outCounters.stateEventLateness.Merge(counters.stateEventLateness);
+        outCounters.readyTeamWait.Merge(counters.readyTeamWait);
+    }
+}
+
+void FShardCoordinator::GetHistograms(FSystemHistograms& outHistograms) const
+{
+    outHistograms = shards[0]->GetHistograms();
+    for (size_t i = 1; i < shards.size(); ++i)
+    {
+        outHistograms.stateEventLateness.Merge(shards[i]->GetHistograms().stateEventLateness);
+        outHistograms.readyTeamWait.Merge(shards[i]->GetHistograms().readyTeamWait);
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "JobSystem.h"
+#include "MatchMakingSystem.h"
+#include "Xoshiro256ss.h"
+
+// how the population is split into regions
+struct FShardSetting
+{
+    int numShards = 1;
+    std::vector<float> regionWeights; // share of the created players per shard, empty or mismatched splits evenly
+
+    // players queued longer than this move to the busiest other shard, 0 keeps everyone in their region
+    uint64_t overflowWaitMillis = 0;
+    int overflowCheckInterval = 1000;
+    int maxOverflowPerCheck = 100; // per shard
+};
+
+// overflow traffic of one shard
+struct FShardCounters
+{
+    uint64_t playersSentOut = 0;
+    uint64_t playersReceived = 0;
+};
+
+/*
+ * Runs one MatchMakingSystem per region. Every shard has its own players, queue, drafted pools and event wheels and
+ * its own random stream. Update runs them side by side for the same world time on one job system shared with the
+ * shards' own phases, then moves overflowing players between them on the calling thread in shard order, so results
+ * don't depend on the thread count.
+ * Player and match ids are per shard.
+ */
+class FShardCoordinator
+{
+public:
+    FShardCoordinator(const FShardSetting& inSetting, EMatchMakeAlgorithm algorithm, uint64_t seed);
+
+    FShardCoordinator(const FShardCoordinator&) = delete;
+    FShardCoordinator& operator=(const FShardCoordinator&) = delete;
+
+    void Update();
+    // earliest world time at which any shard or the overflow check has work to do
+    uint64_t GetNextEventTime() const;
+
+    // new players are split between the shards by FShardSetting::regionWeights
+    void AddToPlayerCreationQueue(int count);
+
+    // applied to every shard, workerThreads size the shared job system. Each shard spills to matchArchiveFile + "." + shard index
+    const FWorldSetting& GetWorldSetting() const { return worldSetting; }
+    void SetWorldSetting(const FWorldSetting& inSetting);
+    const FMatchSetting& GetMatchSetting() const { return matchSetting; }
+    void SetMatchSetting(const FMatchSetting& inSetting);
+    const FShardSetting& GetShardSetting() const { return setting; }
+
+    int GetNumShards() const { return static_cast<int>(shards.size()); }
+    MatchMakingSystem& GetShard(int index) { return *shards[index]; }
+    const MatchMakingSystem& GetShard(int index) const { return *shards[index]; }
+    const FShardCounters& GetShardCounters(int index) const { return shardCounters[index]; }
+    const FJobSystem& GetJobSystem() const { return *jobSystem; }
+    // kept across SetWorldSetting, which may replace the job system
+    void SetTaskTimingEnabled(bool bEnabled);
+
+    // totals over every shard. Players moved out by overflow stay parked in their old shard and aren't counted
+    int GetNumActivePlayers() const;
+    int GetNumPlayerOfState(EPlayerState state) const;
+    double GetAvgQueueTime() const { return GetAvgTimeInState(EPlayerState::InQueue); }
+    double GetAvgGameTime() const { return GetAvgTimeInState(EPlayerState::InGame); }
+    double GetAvgOnlineTime() const;
+    double GetAvgTimeInStateByHour(EPlayerState state, int hour) const;
+    // sums every counter and merges the latency summaries into outCounters, cheap enough for every snapshot
+    void GetCounters(FSystemCounters& outCounters) const;
+    // merges the exact histograms, copies a few megabytes per shard
+    void GetHistograms(FSystemHistograms& outHistograms) const;
+
+private:
+    double GetAvgTimeInState(EPlayerState state) const;
+    void Update_Overflow();
+
+    FShardSetting setting;
+    FWorldSetting worldSetting;
+    FMatchSetting matchSetting;
+
+    std::unique_ptr<FJobSystem> jobSystem; // outlives the shards that share it
+    std::vector<std::unique_ptr<MatchMakingSystem>> shards;
+    std::vector<Xoshiro256SS> shardRandomStates; // swapped in whenever a shard runs
+    std::vector<FShardCounters> shardCounters;
+
+    bool bTaskTiming = false;
+    uint64_t nextOverflowCheckTime = 0;
+    std::vector<FPlayerProfile> overflowPlayers; // reused between checks
+};
@@ -0,0 +1,218 @@
+#include "SimulationRunner.h"
+
+#include <algorithm>
+
+void FSimulationRunner::Start()
+{
+    if (IsRunning()) return;
+    bStopRequested = false;
+    worker = std::thread(&FSimulationRunner::Run, this);
+}
+
+void FSimulationRunner::Stop()
+{
+    if (!IsRunning()) return;
+    bStopRequested = true;
+    worker.join();
+}
+
+void FSimulationRunner::PushCommand(FCommand command)
+{
+    std::lock_guard<std::mutex> lock(commandMutex);
+    pendingCommands.push_back(std::move(command));
+}
+
+void FSimulationRunner::SetView(const FSnapshotView& inView)
+{
+    PushCommand([this, inView](FShardCoordinator&) { view = inView; });
+}
+
+void FSimulationRunner::Run()
+{
+    using Clock = std::chrono::steady_clock;
+
+    WriteSnapshot(snapshots.GetWriteBuffer());
+    snapshots.Publish();
+    Clock::time_point lastPublishTime = Clock::now();
+    Clock::time_point nextTickTime = lastPublishTime;
+
+    while (!bStopRequested)
+    {
+        const bool bRanCommands = ExecuteCommands();
+        Tick();
+
+        const Clock::time_point now = Clock::now();
+        if (bRanCommands || now - lastPublishTime >= std::chrono::milliseconds(snapshotIntervalMillis.load()))
+        {
+            WriteSnapshot(snapshots.GetWriteBuffer());
+            snapshots.Publish();
+            lastPublishTime = now;
+        }
+
+        // pace the ticks, a tick that ran late doesn't make the next ones catch up
+        const int rate = tickRate;
+        if (rate > 0)
+        {
+            nextTickTime += std::chrono::microseconds(1000000 / rate);
+            if (nextTickTime < now)
+            {
+                nextTickTime = now;
+            }
+            std::this_thread::sleep_until(nextTickTime);
+        }
+    }
+}
+
+bool FSimulationRunner::ExecuteCommands()
+{
+    {
+        std::lock_guard<std::mutex> lock(commandMutex);
+        if (pendingCommands.empty()) return false;
+        runningCommands.swap(pendingCommands);
+    }
+
+    for (FCommand& command : runningCommands)
+    {
+        command(coordinator);
+    }
+    runningCommands.clear();
+    return true;
+}
+
+void FSimulationRunner::Tick()
+{
+    // in event driven mode jump straight to the next time the system has work to do
+    if (GetWorldClock().GetMode() == EClockMode::EventDriven)
+    {
+        if (!GetWorldClock().GetIsPaused())
+        {
+            const uint64_t nextEventTime = coordinator.GetNextEventTime();
+            nextEventTime == UINT64_MAX ? GetWorldClock().Advance(GetWorldClock().GetFixedStep()) : GetWorldClock().AdvanceTo(nextEventTime);
+        }
+    }
+    else
+    {
+        GetWorldClock().Update();
+    }
+
+    coordinator.Update();
+    ++tickCount;
+}
+
+void FSimulationRunner::WriteSnapshot(FSimSnapshot& snapshot)
+{
+    snapshot.sequence = publishedCount++;
+
+    snapshot.worldTime = WorldTime::GetWorldTimeMillis();
+    snapshot.bIsPaused = GetWorldClock().GetIsPaused();
+    snapshot.clockMode = GetWorldClock().GetMode();
+    snapshot.fixedStep = GetWorldClock().GetFixedStep();
+
+    snapshot.worldSetting = coordinator.GetWorldSetting();
+    snapshot.matchSetting = coordinator.GetMatchSetting();
+
+    snapshot.numPlayers = coordinator.GetNumActivePlayers();
+    snapshot.avgQueueTime = coordinator.GetAvgQueueTime();
+    snapshot.avgGameTime = coordinator.GetAvgGameTime();
+    for (size_t i = 0; i < snapshot.playersPerState.size(); ++i)
+    {
+        snapshot.playersPerState[i] = coordinator.GetNumPlayerOfState(static_cast<EPlayerState>(i));
+    }
+
+    coordinator.GetCounters(counters);
+    snapshot.matchesStarted = counters.matchesStarted;
+    snapshot.matchesCompleted = counters.matchesCompleted;
+    snapshot.stateEventBacklog = counters.stateEventBacklog;
+    snapshot.peakStateEventBacklog = counters.peakStateEventBacklog;
+    snapshot.stateEventLatenessAvg = counters.stateEventLateness.GetAverage();
+    snapshot.stateEventLatenessP99 = counters.stateEventLateness.GetPercentile(0.99);
+    snapshot.stateEventLatenessMax = counters.stateEventLateness.max;
+
+    snapshot.numOngoingMatches = 0;
+    snapshot.shards.resize(coordinator.GetNumShards());
+    for (int i = 0; i < coordinator.GetNumShards(); ++i)
+    {
+        const MatchMakingSystem& shard = coordinator.GetShard(i);
+        FShardSnapshot& shardSnapshot = snapshot.shards[i];
+        shardSnapshot.numPlayers = static_cast<int>(shard.GetAllPlayers().size()) - shard.GetNumPlayerOfState(EPlayerState::None);
+        shardSnapshot.numQueued = shard.GetNumPlayerOfState(EPlayerState::InQueue);
+        shardSnapshot.numOngoingMatches = static_cast<int>(shard.GetOngoingMatches().Size());
+        shardSnapshot.avgQueueTime = shard.GetAvgQueueTime();
+        shardSnapshot.avgGameTime = shard.GetAvgGameTime();
+        shardSnapshot.matchesCompleted = shard.GetCounters().matchesCompleted;
+        shardSnapshot.stateEventBacklog = shard.GetCounters().stateEventBacklog;
+        shardSnapshot.playersSentOut = coordinator.GetShardCounters(i).playersSentOut;
+        shardSnapshot.playersReceived = coordinator.GetShardCounters(i).playersReceived;
+        snapshot.numOngoingMatches += shardSnapshot.numOngoingMatches;
+    }
+
+    // the UI can ask for any index, stay on an existing shard
+    view.shardIndex = std::clamp(view.shardIndex, 0, coordinator.GetNumShards() - 1);
+    const MatchMakingSystem& system = coordinator.GetShard(view.shardIndex);
+    const FPlayerStore& players = system.GetAllPlayers();
+
+    snapshot.view = view;
+    snapshot.playerList.clear();
+    for (int id : system.GetSortedPlayerList(view.sortingType, view.bAscending))
+    {
+        const VirtualPlayer& player = players[id];
+        snapshot.playerList.push_back({id, player.GetState(), player.GetStatByTypeForSort(view.sortingType)});
+    }
+
+    snapshot.draftedPoolSizes.clear();
+    for (const std::vector<VirtualPlayer*>& pool : system.GetDraftedPools())
+    {
+        snapshot.draftedPoolSizes.push_back(static_cast<int>(pool.size()));
+    }
+
+    WritePlayerDetail(system, snapshot.selectedPlayer);
+    snapshot.debugText = debugText;
+}
+
+void FSimulationRunner::WritePlayerDetail(const MatchMakingSystem& system, FPlayerDetailSnapshot& detail)
+{
+    const FPlayerStore& players = system.GetAllPlayers();
+    if (view.selectedPlayerId < 0 || view.selectedPlayerId >= static_cast<int>(players.size()))
+    {
+        detail.id = -1;
+        return;
+    }
+
+    const VirtualPlayer& player = players[view.selectedPlayerId];
+    detail.id = player.GetId();
+    detail.state = player.GetState();
+    detail.timeInCurrentState = player.GetTimeInCurrentState();
+    detail.traits = player.GetTraits();
+    detail.stats = {player.GetAgr(), player.GetFle(), player.GetGri(), player.GetEdr(), player.GetIns(), player.GetCre(), player.GetPre()};
+    detail.rank = system.GetPlayerRank(view.sortingType, detail.id);
+    detail.percentile = system.GetPlayerPercentile(view.sortingType, detail.id);
+    detail.numWon = static_cast<int>(player.GetWonMatches().size());
+    detail.numLost = static_cast<int>(player.GetLostMatches().size());
+    detail.onlineTime = player.GetOnlineTime();
+    detail.avgQueueTime = player.GetAvgQueueTime();
+    detail.avgGameTime = player.GetAvgGameTime();
+    detail.desiredOnlineTimes = player.GetDesiredOnlineTimes();
+    detail.activityLog = player.GetActivityLog();
+
+    const FMatch* ongoingMatch = player.GetOngoingMatch().IsValid() ? system.GetOngoingMatches().Find(player.GetOngoingMatch()) : nullptr;
+    detail.bHasOngoingMatch = ongoingMatch != nullptr;
+    if (ongoingMatch)
+    {
+        detail.ongoingMatch = *ongoingMatch;
+    }
+
+    // only the displayed page of the history, the vectors keep their capacity between snapshots
+    const std::vector<int>& history = player.GetMatchHistory();
+    detail.numMatchesPlayed = static_cast<int>(history.size());
+    const int first = std::clamp(view.firstHistoryIndex, 0, detail.numMatchesPlayed);
+    const int count = std::clamp(view.historyCount, 0, detail.numMatchesPlayed - first);
+    detail.historyIds.assign(history.begin() + first, history.begin() + first + count);
+    detail.historyMatches.resize(count);
+    for (int i = 0; i < count; ++i)
+    {
+        if (!system.FindMatch(detail.historyIds[i], detail.historyMatches[i]))
+        {
+            detail.historyMatches[i].Reset();
+        }
+    }
+}
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "MatchMakingSystem.h"
+#include "MM_Elements.h"
+#include "ShardCoordinator.h"
+#include "TripleBuffer.h"
+#include "WorldClock.h"
+
+// What the UI is looking at, decides which players and matches get copied into the snapshots
+struct FSnapshotView
+{
+    int shardIndex = 0; // player list, drafted pools and the selected player come from this shard
+    int selectedPlayerId = -1;
+    EPlayerSortingType sortingType = WinRate;
+    bool bAscending = false;
+    int firstHistoryIndex = 0; // match history entries of the selected player copied with their match data
+    int historyCount = 5;
+
+    bool operator==(const FSnapshotView& other) const
+    {
+        return shardIndex == other.shardIndex && selectedPlayerId == other.selectedPlayerId && sortingType == other.sortingType && bAscending == other.bAscending
+            && firstHistoryIndex == other.firstHistoryIndex && historyCount == other.historyCount;
+    }
+    bool operator!=(const FSnapshotView& other) const { return !(*this == other); }
+};
+
+// One row of the sorted player list
+struct FPlayerListEntry
+{
+    int id = -1;
+    EPlayerState state = EPlayerState::None;
+    double sortValue = 0.0;
+};
+
+// One row of the shard table
+struct FShardSnapshot
+{
+    int numPlayers = 0; // players moved out by overflow don't count
+    int numQueued = 0;
+    int numOngoingMatches = 0;
+    double avgQueueTime = 0.0;
+    double avgGameTime = 0.0;
+    uint64_t matchesCompleted = 0;
+    size_t stateEventBacklog = 0;
+    uint64_t playersSentOut = 0;
+    uint64_t playersReceived = 0;
+};
+
+// Everything the detail panel shows about the selected player
+struct FPlayerDetailSnapshot
+{
+    int id = -1; // -1 when no player is selected
+    EPlayerState state = EPlayerState::None;
+    uint64_t timeInCurrentState = 0;
+    EPlayerTrait traits = EPlayerTrait::None;
+    std::array<int, 7> stats{}; // Agr, Fle, Gri, Edr, Ins, Cre, Pre
+    int rank = -1; // in the view's sorting type
+    double percentile = 0.0;
+    int numWon = 0;
+    int numLost = 0;
+    uint64_t onlineTime = 0;
+    double avgQueueTime = 0.0;
+    double avgGameTime = 0.0;
+    std::vector<std::pair<uint64_t, uint64_t>> desiredOnlineTimes;
+    FActivityLog activityLog;
+
+    bool bHasOngoingMatch = false;
+    FMatch ongoingMatch;
+
+    // history entries [FSnapshotView::firstHistoryIndex, +historyCount), matchId stays -1 for matches no longer archived
+    int numMatchesPlayed = 0;
+    std::vector<int> historyIds;
+    std::vector<FMatch> historyMatches;
+};
+
+// Immutable copy of the world state published by the simulation thread for the UI
+struct FSimSnapshot
+{
+    uint64_t sequence = 0; // number of snapshots published before this one
+
+    // clock
+    uint64_t worldTime = 0;
+    bool bIsPaused = false;
+    EClockMode clockMode = EClockMode::RealTime;
+    uint64_t fixedStep = 0;
+
+    // settings, edited by the UI through commands
+    FWorldSetting worldSetting;
+    FMatchSetting matchSetting;
+
+    // population, summed over every shard
+    int numPlayers = 0;
+    int numOngoingMatches = 0;
+    double avgQueueTime = 0.0;
+    double avgGameTime = 0.0;
+    std::array<int, static_cast<size_t>(EPlayerState::IterationRef)> playersPerState{};
+
+    // counters of every shard. Lateness is in world millis, its p99 comes from the coarse FValueSummary
+    uint64_t matchesStarted = 0;
+    uint64_t matchesCompleted = 0;
+    size_t stateEventBacklog = 0;
+    size_t peakStateEventBacklog = 0;
+    double stateEventLatenessAvg = 0.0;
+    double stateEventLatenessP99 = 0.0;
+    double stateEventLatenessMax = 0.0;
+
+    std::vector<FShardSnapshot> shards;
+
+    // built for this view
+    FSnapshotView view;
+    std::vector<FPlayerListEntry> playerList; // leader list of view.sortingType in view order, ids are per shard
+    std::vector<int> draftedPoolSizes;
+    FPlayerDetailSnapshot selectedPlayer;
+
+    std::string debugText;
+};
+
+/*
+ * Runs the shards of a FShardCoordinator on its own thread. The world clock and the shards are only touched by that thread: other
+ * threads change them through commands, executed before the next tick, and read them through snapshots published at
+ * a fixed real time rate. Reading the latest snapshot never takes a lock nor waits for the simulation.
+ */
+class FSimulationRunner
+{
+public:
+    using FCommand = std::function<void(FShardCoordinator&)>;
+
+    explicit FSimulationRunner(FShardCoordinator& inCoordinator) : coordinator(inCoordinator) {}
+    ~FSimulationRunner() { Stop(); }
+
+    void Start();
+    void Stop(); // waits for the current tick to finish
+    bool IsRunning() const { return worker.joinable(); }
+
+    // ticks per real second, 0 ticks back to back. Real time and fixed step clocks advance once per tick
+    void SetTickRate(int ticksPerSecond) { tickRate = ticksPerSecond; }
+    void SetSnapshotInterval(int millis) { snapshotIntervalMillis = millis; }
+
+    // queued for the simulation thread, the snapshot after the command ran is published right away
+    void PushCommand(FCommand command);
+    void SetView(const FSnapshotView& inView);
+
+    // simulation thread only, i.e. from inside a command. Shown by every following snapshot
+    void SetDebugText(std::string text) { debugText = std::move(text); }
+
+    // reader thread only. Stays unchanged until the next call
+    const FSimSnapshot& AcquireSnapshot() { return snapshots.Acquire(); }
+    uint64_t GetTickCount() const { return tickCount; }
+
+private:
+    void Run();
+    bool ExecuteCommands(); // true if any command ran
+    void Tick();
+    void WriteSnapshot(FSimSnapshot& snapshot);
+    void WritePlayerDetail(const MatchMakingSystem& system, FPlayerDetailSnapshot& detail);
+
+    FShardCoordinator& coordinator;
+    std::thread worker;
+    std::atomic<bool> bStopRequested{false};
+    std::atomic<int> tickRate{60}; // the GUI used to tick once per 60fps frame
+    std::atomic<int> snapshotIntervalMillis{50};
+    std::atomic<uint64_t> tickCount{0};
+
+    std::mutex commandMutex; // only guards the hand off, commands run outside of it
+    std::vector<FCommand> pendingCommands;
+    std::vector<FCommand> runningCommands;
+
+    // simulation thread state
+    FSnapshotView view;
+    std::string debugText;
+    uint64_t publishedCount = 0;
+    FSystemCounters counters; // summed over the shards for every snapshot
+    TTripleBuffer<FSimSnapshot> snapshots;
+};
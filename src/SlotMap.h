@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Stable reference into a TSlotMap. The generation changes every time a slot is reused, so a handle to a removed
+// element stops resolving instead of pointing at whatever took its place
+struct FSlotHandle
+{
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool IsValid() const { return index != UINT32_MAX; }
+    bool operator==(const FSlotHandle& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const FSlotHandle& other) const { return !(*this == other); }
+};
+
+/*
+ * Slot map: values are packed in a dense array so iterating them is a linear sweep, handles go through a slot table
+ * that remembers where each value currently sits. Removing swaps the last value into the hole, so the dense order is
+ * not stable, and puts the slot on a free list for reuse.
+ */
+template <typename T>
+class TSlotMap
+{
+public:
+    FSlotHandle Insert(T value)
+    {
+        uint32_t slotIndex;
+        if (freeHead != NONE)
+        {
+            slotIndex = freeHead;
+            freeHead = slots[slotIndex].denseIndex;
+        }
+        else
+        {
+            slotIndex = static_cast<uint32_t>(slots.size());
+            slots.emplace_back();
+        }
+
+        slots[slotIndex].denseIndex = static_cast<uint32_t>(values.size());
+        values.push_back(std::move(value));
+        denseToSlot.push_back(slotIndex);
+        return {slotIndex, slots[slotIndex].generation};
+    }
+
+    // returns false for stale or invalid handles
+    bool Remove(FSlotHandle handle)
+    {
+        if (!Contains(handle)) return false;
+
+        FSlot& slot = slots[handle.index];
+        const uint32_t denseIndex = slot.denseIndex;
+        const uint32_t lastIndex = static_cast<uint32_t>(values.size()) - 1;
+        if (denseIndex != lastIndex)
+        {
+            values[denseIndex] = std::move(values[lastIndex]);
+            denseToSlot[denseIndex] = denseToSlot[lastIndex];
+            slots[denseToSlot[denseIndex]].denseIndex = denseIndex;
+        }
+        values.pop_back();
+        denseToSlot.pop_back();
+
+        ++slot.generation;
+        slot.denseIndex = freeHead;
+        freeHead = handle.index;
+        return true;
+    }
+
+    // removing bumps the slot generation, so only handles handed out since the last insert into the slot match
+    bool Contains(FSlotHandle handle) const
+    {
+        return handle.index < slots.size() && slots[handle.index].generation == handle.generation;
+    }
+
+    T* Find(FSlotHandle handle) { return Contains(handle) ? &values[slots[handle.index].denseIndex] : nullptr; }
+    const T* Find(FSlotHandle handle) const { return Contains(handle) ? &values[slots[handle.index].denseIndex] : nullptr; }
+
+    // dense access, indices shift when an element is removed
+    size_t Size() const { return values.size(); }
+    bool IsEmpty() const { return values.empty(); }
+    T& GetAt(size_t denseIndex) { return values[denseIndex]; }
+    const T& GetAt(size_t denseIndex) const { return values[denseIndex]; }
+    FSlotHandle GetHandleAt(size_t denseIndex) const { return {denseToSlot[denseIndex], slots[denseToSlot[denseIndex]].generation}; }
+
+    typename std::vector<T>::iterator begin() { return values.begin(); }
+    typename std::vector<T>::iterator end() { return values.end(); }
+    typename std::vector<T>::const_iterator begin() const { return values.begin(); }
+    typename std::vector<T>::const_iterator end() const { return values.end(); }
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    struct FSlot
+    {
+        uint32_t denseIndex = NONE; // next free slot while the slot is on the free list
+        uint32_t generation = 0;
+    };
+
+    std::vector<T> values;
+    std::vector<uint32_t> denseToSlot;
+    std::vector<FSlot> slots;
+    uint32_t freeHead = NONE;
+};
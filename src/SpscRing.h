@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/*
+ * Lock free bounded queue between one producer thread and one consumer thread.
+ * Both sides work on the slot in place: the producer fills GetWriteSlot() and publishes it with Push, the consumer
+ * reads GetReadSlot() and hands it back with Pop. Slots are reused, so a slot holding a vector keeps its capacity.
+ */
+template <typename T>
+class TSpscRing
+{
+public:
+    // capacity is rounded up to a power of two
+    explicit TSpscRing(size_t minCapacity)
+    {
+        size_t capacity = 1;
+        while (capacity < minCapacity) { capacity <<= 1; }
+        slots.resize(capacity);
+        mask = capacity - 1;
+    }
+
+    TSpscRing(const TSpscRing&) = delete;
+    TSpscRing& operator=(const TSpscRing&) = delete;
+
+    size_t Capacity() const { return slots.size(); }
+    // exact only while neither side is running
+    size_t Size() const { return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire); }
+
+    // producer only, nullptr while the ring is full
+    T* GetWriteSlot()
+    {
+        const size_t writeIndex = tail.load(std::memory_order_relaxed);
+        if (writeIndex - head.load(std::memory_order_acquire) == slots.size()) return nullptr;
+        return &slots[writeIndex & mask];
+    }
+    void Push() { tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    // consumer only, nullptr while the ring is empty
+    T* GetReadSlot()
+    {
+        const size_t readIndex = head.load(std::memory_order_relaxed);
+        if (readIndex == tail.load(std::memory_order_acquire)) return nullptr;
+        return &slots[readIndex & mask];
+    }
+    void Pop() { head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+private:
+    std::vector<T> slots;
+    size_t mask = 0;
+    alignas(64) std::atomic<size_t> head{0}; // next slot to read, written by the consumer
+    alignas(64) std::atomic<size_t> tail{0}; // next slot to write, written by the producer
+};
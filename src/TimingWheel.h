@@ -0,0 +1,341 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/*
+ * Hierarchical timing wheel keyed by an integer handle (e.g. a player id), each handle has at most one pending entry.
+ * Scheduling and cancelling are O(1), due entries are extracted a whole slot at a time. Level 0 has one slot per
+ * millisecond, every level above covers 256 slots of the level below, entries further out than the top level wait in
+ * an overflow list until the top level wraps.
+ */
+template <typename T>
+class TTimingWheel
+{
+public:
+    struct FEntry
+    {
+        int handle = -1;
+        uint64_t time = 0;
+        T payload{};
+    };
+
+    TTimingWheel()
+    {
+        for (int level = 0; level < LEVELS; ++level)
+        {
+            for (int slot = 0; slot < SLOTS; ++slot)
+            {
+                heads[level][slot] = NONE;
+                tails[level][slot] = NONE;
+            }
+        }
+    }
+
+    // Schedules the handle at the given time, replacing its pending entry if it has one
+    void Schedule(int handle, uint64_t time, const T& payload)
+    {
+        if (handle >= static_cast<int>(nodes.size()))
+        {
+            nodes.resize(handle + 1);
+        }
+
+        Cancel(handle);
+        FNode& node = nodes[handle];
+        node.time = time;
+        node.payload = payload;
+        Link(handle);
+        ++count;
+    }
+
+    // Removes the pending entry of the handle, returns false if it had none
+    bool Cancel(int handle)
+    {
+        if (!IsScheduled(handle)) return false;
+        Unlink(handle);
+        --count;
+        return true;
+    }
+
+    bool IsScheduled(int handle) const { return handle >= 0 && handle < static_cast<int>(nodes.size()) && nodes[handle].level != NOT_SCHEDULED; }
+    size_t Size() const { return count; }
+    bool IsEmpty() const { return count == 0; }
+
+    // Moves entries due at or before 'now' into outDue in time order, stops after maxCount entries.
+    // Entries left behind because of maxCount stay scheduled and are returned first on the next call
+    void ExtractDue(uint64_t now, std::vector<FEntry>& outDue, size_t maxCount = SIZE_MAX)
+    {
+        size_t extracted = 0;
+        while (cursor <= now && extracted < maxCount)
+        {
+            if (count == 0)
+            {
+                cursor = now + 1;
+                return;
+            }
+
+            const int slot = FindNextOccupied(0, static_cast<int>(cursor & SLOT_MASK));
+            if (slot < 0)
+            {
+                // nothing left in this block, jump to the next block that has entries waiting on a higher level
+                const uint64_t nextBlock = GetNextCascadeTime();
+                if (nextBlock > now)
+                {
+                    cursor = now + 1;
+                    if (cursor == nextBlock)
+                    {
+                        Cascade();
+                    }
+                    return;
+                }
+                cursor = nextBlock;
+                Cascade();
+                continue;
+            }
+
+            const uint64_t slotTime = (cursor & ~static_cast<uint64_t>(SLOT_MASK)) | static_cast<uint64_t>(slot);
+            if (slotTime > now)
+            {
+                cursor = now + 1;
+                return;
+            }
+            cursor = slotTime;
+
+            // bulk extract the slot
+            while (heads[0][slot] != NONE && extracted < maxCount)
+            {
+                int handle = heads[0][slot];
+                FNode& node = nodes[handle];
+                outDue.push_back({handle, node.time, node.payload});
+                Unlink(handle);
+                --count;
+                ++extracted;
+            }
+
+            if (heads[0][slot] == NONE)
+            {
+                ++cursor;
+                if ((cursor & SLOT_MASK) == 0)
+                {
+                    Cascade();
+                }
+            }
+        }
+    }
+
+    // Number of entries due at or before 'now' that have not been extracted yet, walks the due slots so only call it when behind
+    size_t CountDue(uint64_t now) const
+    {
+        if (count == 0 || cursor > now) return 0;
+
+        size_t due = 0;
+        for (int level = 0; level < LEVELS; ++level)
+        {
+            const int shift = level * SLOT_BITS;
+            const uint64_t levelBase = cursor & ~((static_cast<uint64_t>(1) << (shift + SLOT_BITS)) - 1);
+            for (int slot = FindNextOccupied(level, static_cast<int>((cursor >> shift) & SLOT_MASK)); slot >= 0; slot = slot + 1 < SLOTS ? FindNextOccupied(level, slot + 1) : -1)
+            {
+                if ((levelBase | (static_cast<uint64_t>(slot) << shift)) > now) break;
+                due += CountDueInList(heads[level][slot], now);
+            }
+        }
+        return due + CountDueInList(overflowHead, now);
+    }
+
+    // Earliest scheduled time, UINT64_MAX when empty
+    uint64_t GetNextTime() const
+    {
+        if (count == 0) return UINT64_MAX;
+
+        // every entry of a level is later than all entries of the levels below, so the first occupied slot wins
+        for (int level = 0; level < LEVELS; ++level)
+        {
+            int fromSlot = static_cast<int>((cursor >> (level * SLOT_BITS)) & SLOT_MASK);
+            int slot = FindNextOccupied(level, fromSlot);
+            if (slot >= 0)
+            {
+                return level == 0 ? (cursor & ~static_cast<uint64_t>(SLOT_MASK)) | static_cast<uint64_t>(slot) : GetMinTime(heads[level][slot]);
+            }
+        }
+        return GetMinTime(overflowHead);
+    }
+
+private:
+    static constexpr int SLOT_BITS = 8;
+    static constexpr int SLOTS = 1 << SLOT_BITS;
+    static constexpr int SLOT_MASK = SLOTS - 1;
+    static constexpr int LEVELS = 4;
+    static constexpr int WORDS = SLOTS / 64;
+    static constexpr int NONE = -1;
+    static constexpr int8_t NOT_SCHEDULED = -1;
+    static constexpr int8_t OVERFLOW_LEVEL = LEVELS;
+
+    struct FNode
+    {
+        uint64_t time = 0;
+        T payload{};
+        int prev = NONE;
+        int next = NONE;
+        int8_t level = NOT_SCHEDULED;
+        uint8_t slot = 0;
+    };
+
+    std::vector<FNode> nodes; // indexed by handle
+    int heads[LEVELS][SLOTS] = {};
+    int tails[LEVELS][SLOTS] = {};
+    uint64_t occupied[LEVELS][WORDS] = {};
+    int overflowHead = NONE;
+    int overflowTail = NONE;
+    uint64_t cursor = 0; // every entry before this time has been extracted
+    size_t count = 0;
+
+    static int CountTrailingZeros(uint64_t value)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, value);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(value);
+#endif
+    }
+
+    // first occupied slot at or after fromSlot on the level, -1 if none
+    int FindNextOccupied(int level, int fromSlot) const
+    {
+        int word = fromSlot >> 6;
+        uint64_t bits = occupied[level][word] & (~0ULL << (fromSlot & 63));
+        while (true)
+        {
+            if (bits != 0)
+            {
+                return (word << 6) + CountTrailingZeros(bits);
+            }
+            if (++word >= WORDS) return -1;
+            bits = occupied[level][word];
+        }
+    }
+
+    size_t CountDueInList(int head, uint64_t now) const
+    {
+        size_t due = 0;
+        for (int handle = head; handle != NONE; handle = nodes[handle].next)
+        {
+            due += nodes[handle].time <= now ? 1 : 0;
+        }
+        return due;
+    }
+
+    uint64_t GetMinTime(int head) const
+    {
+        uint64_t minTime = UINT64_MAX;
+        for (int handle = head; handle != NONE; handle = nodes[handle].next)
+        {
+            minTime = nodes[handle].time < minTime ? nodes[handle].time : minTime;
+        }
+        return minTime;
+    }
+
+    // place the node on the level where its time differs from the cursor, anything already late goes to the current slot
+    void Link(int handle)
+    {
+        FNode& node = nodes[handle];
+        const uint64_t time = node.time < cursor ? cursor : node.time;
+        const uint64_t diff = time ^ cursor;
+
+        int level = 0;
+        while (level < LEVELS && (diff >> ((level + 1) * SLOT_BITS)) != 0)
+        {
+            ++level;
+        }
+
+        node.next = NONE;
+        if (level >= LEVELS)
+        {
+            node.level = OVERFLOW_LEVEL;
+            node.slot = 0;
+            node.prev = overflowTail;
+            if (overflowTail != NONE) { nodes[overflowTail].next = handle; } else { overflowHead = handle; }
+            overflowTail = handle;
+            return;
+        }
+
+        const int slot = static_cast<int>((time >> (level * SLOT_BITS)) & SLOT_MASK);
+        node.level = static_cast<int8_t>(level);
+        node.slot = static_cast<uint8_t>(slot);
+        node.prev = tails[level][slot];
+        if (tails[level][slot] != NONE) { nodes[tails[level][slot]].next = handle; } else { heads[level][slot] = handle; }
+        tails[level][slot] = handle;
+        occupied[level][slot >> 6] |= 1ULL << (slot & 63);
+    }
+
+    void Unlink(int handle)
+    {
+        FNode& node = nodes[handle];
+        int& head = node.level == OVERFLOW_LEVEL ? overflowHead : heads[node.level][node.slot];
+        int& tail = node.level == OVERFLOW_LEVEL ? overflowTail : tails[node.level][node.slot];
+
+        if (node.prev != NONE) { nodes[node.prev].next = node.next; } else { head = node.next; }
+        if (node.next != NONE) { nodes[node.next].prev = node.prev; } else { tail = node.prev; }
+
+        if (node.level != OVERFLOW_LEVEL && head == NONE)
+        {
+            occupied[node.level][node.slot >> 6] &= ~(1ULL << (node.slot & 63));
+        }
+        node.level = NOT_SCHEDULED;
+        node.prev = NONE;
+        node.next = NONE;
+    }
+
+    // detaches a whole list and links every entry again relative to the new cursor, which puts them on lower levels
+    void Relink(int& head, int& tail)
+    {
+        int handle = head;
+        head = NONE;
+        tail = NONE;
+        while (handle != NONE)
+        {
+            int next = nodes[handle].next;
+            Link(handle);
+            handle = next;
+        }
+    }
+
+    // start of the next level 0 block whose cascade brings entries down, UINT64_MAX if no higher level holds any
+    uint64_t GetNextCascadeTime() const
+    {
+        for (int level = 1; level < LEVELS; ++level)
+        {
+            const int shift = level * SLOT_BITS;
+            const int fromSlot = static_cast<int>((cursor >> shift) & SLOT_MASK) + 1;
+            const int slot = fromSlot < SLOTS ? FindNextOccupied(level, fromSlot) : -1;
+            if (slot >= 0)
+            {
+                const uint64_t levelBase = cursor & ~((static_cast<uint64_t>(1) << (shift + SLOT_BITS)) - 1);
+                return levelBase | (static_cast<uint64_t>(slot) << shift);
+            }
+        }
+
+        if (overflowHead == NONE) return UINT64_MAX;
+        const int topShift = LEVELS * SLOT_BITS;
+        return ((cursor >> topShift) + 1) << topShift;
+    }
+
+    // called when the cursor enters a new level 0 block, pulls the matching slot of each wrapped level down
+    void Cascade()
+    {
+        for (int level = 1; level < LEVELS; ++level)
+        {
+            const int slot = static_cast<int>((cursor >> (level * SLOT_BITS)) & SLOT_MASK);
+            occupied[level][slot >> 6] &= ~(1ULL << (slot & 63));
+            Relink(heads[level][slot], tails[level][slot]);
+            if (slot != 0) return;
+        }
+        Relink(overflowHead, overflowTail);
+    }
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/*
+ * Lock free single writer, single reader hand off of the latest value.
+ * The writer fills the back buffer and publishes it by swapping it with the shared middle buffer, the reader swaps the
+ * middle buffer with its front buffer when something new was published. Neither side ever waits for the other, the
+ * reader just keeps the last value until the next publish. Buffers are reused, so filling one can keep its capacity.
+ */
+template <typename T>
+class TTripleBuffer
+{
+public:
+    // only the writer thread may touch this buffer until Publish
+    T& GetWriteBuffer() { return buffers[back]; }
+
+    void Publish()
+    {
+        back = middle.exchange(back | FRESH_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // latest published value, stays valid and unchanged until the reader's next call
+    const T& Acquire()
+    {
+        if (middle.load(std::memory_order_relaxed) & FRESH_BIT)
+        {
+            front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+        }
+        return buffers[front];
+    }
+
+    // true if a value was published since the last Acquire
+    bool HasNewValue() const { return (middle.load(std::memory_order_relaxed) & FRESH_BIT) != 0; }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t FRESH_BIT = 0x4;
+
+    T buffers[3];
+    uint8_t front = 0;                  // reader only
+    std::atomic<uint8_t> middle{1};     // index of the shared buffer, plus FRESH_BIT once the writer put a new value there
+    uint8_t back = 2;                   // writer only
+};
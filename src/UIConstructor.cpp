@@ -1,138 +1,230 @@
 #include "UIConstructor.h"
 
+#include <algorithm>
 #include <sstream>
 
 #include "Logger.h"
 #include "MatchMakingSystem.h"
 #include "MM_Elements.h"
+#include "SimulationRunner.h"
 #include "Utility.h"
 
 std::unordered_map<int, bool> matchListHeaderState;
 int numOfPlayersToAdd = 5000;
-int currentViewingPlayerId = -1;
-
-std::vector<VirtualPlayer> currentPlayerList;
-std::vector<VirtualPlayer> sortedPlayersForImPlot;
-int playerListUpdateDelay = 1000; // in millisec
-int playerPlotUpdateDelay = 200;
-std::chrono::steady_clock::time_point lastPlayerListUpdateTime;
-std::chrono::steady_clock::time_point lastPlayerPlotUpdateTime;
-
-EPlayerSortingType sortingType = WinRate;
-bool bIsAscSort;
-int matchDisplayIndex = 0;
-std::string textDebugLogResult = " ";
-
-// Runs the MM simulator on update and renders UI
-void DrawMMUI(MatchMakingSystem* mmSystem)
+
+// what the panels look at, sent to the runner whenever it changes. The snapshot catches up a tick later
+FSnapshotView requestedView;
+FSnapshotView lastSentView;
+
+// Renders the latest snapshot of the simulation running on the runner's thread
+void DrawMMUI(FSimulationRunner* simRunner)
 {
+    const FSimSnapshot& snapshot = simRunner->AcquireSnapshot();
+
     // Draw MMSystem UIs
-    DrawControlPanel(mmSystem);
-    DrawStatusPanel(mmSystem);
-    //DrawStatsGraph(mmSystem);
-    DrawPlayerDetail(mmSystem);
-    DrawPlayerStatusGraph(mmSystem);
+    DrawControlPanel(simRunner, snapshot);
+    DrawStatusPanel(snapshot);
+    //DrawStatsGraph(snapshot);
+    DrawPlayerDetail(snapshot);
+    DrawPlayerStatusGraph(snapshot);
 
     // DEPRICATED
     //DrawMatchHistory(mmSystem);
-    //DrawDebug(mmSystem);
+    //DrawDebug(snapshot);
+
+    if (requestedView != lastSentView)
+    {
+        simRunner->SetView(requestedView);
+        lastSentView = requestedView;
+    }
 }
 
-void DrawControlPanel(MatchMakingSystem* mmSystem)
+void DrawControlPanel(FSimulationRunner* simRunner, const FSimSnapshot& snapshot)
 {
     ImGui::Begin("Controls");
 
+    // the clock belongs to the simulation thread, every change goes through a command
     ImGui::SeparatorText("World Time Control");
-    if (ImGui::Button("x.5")) { GetWorldClock().SetSpeed(0.5f); }
+    if (ImGui::Button("x.5")) { simRunner->PushCommand([](FShardCoordinator&) { GetWorldClock().SetSpeed(0.5f); }); }
+    ImGui::SameLine();
+    if (ImGui::Button("x1")) { simRunner->PushCommand([](FShardCoordinator&) { GetWorldClock().SetSpeed(1.0f); }); }
+    ImGui::SameLine();
+    if (ImGui::Button("x3")) { simRunner->PushCommand([](FShardCoordinator&) { GetWorldClock().SetSpeed(3.0f); }); }
     ImGui::SameLine();
-    if (ImGui::Button("x1")) { GetWorldClock().SetSpeed(1.0f); }
+    if (ImGui::Button("x20")) { simRunner->PushCommand([](FShardCoordinator&) { GetWorldClock().SetSpeed(20.0f); }); }
     ImGui::SameLine();
-    if (ImGui::Button("x3")) { GetWorldClock().SetSpeed(3.0f); }
+    if (ImGui::Button(snapshot.bIsPaused ? "Resume" : "Pause"))
+    {
+        const bool bResume = snapshot.bIsPaused;
+        simRunner->PushCommand([bResume](FShardCoordinator&) { bResume ? GetWorldClock().Resume() : GetWorldClock().Pause(); });
+    }
+    if (snapshot.bIsPaused) { ImGui::SameLine(); ImGui::Text("SYSTEM PAUSED"); }
+
+    int clockMode = static_cast<int>(snapshot.clockMode);
+    ImGui::RadioButton("Real time", &clockMode, static_cast<int>(EClockMode::RealTime));
     ImGui::SameLine();
-    if (ImGui::Button("x20")) { GetWorldClock().SetSpeed(20.0f); }
+    ImGui::RadioButton("Fixed step", &clockMode, static_cast<int>(EClockMode::FixedStep));
     ImGui::SameLine();
-    if (ImGui::Button(GetWorldClock().GetIsPaused() ? "Resume" : "Pause"))
+    ImGui::RadioButton("Skip to next event", &clockMode, static_cast<int>(EClockMode::EventDriven));
+    if (clockMode != static_cast<int>(snapshot.clockMode))
+    {
+        simRunner->PushCommand([clockMode](FShardCoordinator&) { GetWorldClock().SetMode(static_cast<EClockMode>(clockMode)); });
+    }
+    if (snapshot.clockMode == EClockMode::FixedStep)
     {
-        GetWorldClock().GetIsPaused() ? GetWorldClock().Resume() : GetWorldClock().Pause();
+        ImGui::SameLine();
+        int step = static_cast<int>(snapshot.fixedStep);
+        ImGui::PushItemWidth(ImGui::GetContentRegionAvail().x);
+        if (ImGui::InputInt("##fixedStep", &step) && step > 0)
+        {
+            simRunner->PushCommand([step](FShardCoordinator&) { GetWorldClock().SetFixedStep(static_cast<uint64_t>(step)); });
+        }
+        ImGui::PopItemWidth();
     }
-    if (GetWorldClock().GetIsPaused()) { ImGui::SameLine(); ImGui::Text("SYSTEM PAUSED"); }
     
     ImGui::SeparatorText("MMSystem Control");
     if (ImGui::Button("Create Player"))
     {
-        mmSystem->AddToPlayerCreationQueue(numOfPlayersToAdd);
+        const int count = numOfPlayersToAdd;
+        simRunner->PushCommand([count](FShardCoordinator& coordinator) { coordinator.AddToPlayerCreationQueue(count); });
     }
     ImGui::SameLine();
     ImGui::PushItemWidth(ImGui::GetContentRegionAvail().x);
     ImGui::InputInt("##numPlayerToAdd", &numOfPlayersToAdd);
     ImGui::PopItemWidth();
 
-    FWorldSetting wSetting = mmSystem->GetWorldSetting();
-    mmSystem->SetWorldSetting(wSetting);
+    FWorldSetting wSetting = snapshot.worldSetting;
+    ImGui::Text("Event budget per update (us, 0 = unlimited): ");
+    if (ImGui::InputInt("##eventBudget", &wSetting.eventBudgetMicros))
+    {
+        const int budget = (std::max)(wSetting.eventBudgetMicros, 0);
+        simRunner->PushCommand([budget](FShardCoordinator& coordinator)
+        {
+            FWorldSetting setting = coordinator.GetWorldSetting();
+            setting.eventBudgetMicros = budget;
+            coordinator.SetWorldSetting(setting);
+        });
+    }
     
-    FMatchSetting mSetting = mmSystem->GetMatchSetting();
+    FMatchSetting mSetting = snapshot.matchSetting;
+    bool bMatchSettingChanged = false;
     ImGui::Text("System refresh speed: ");
-    ImGui::InputInt("##sysSpeed", &mSetting.draftInterval);
+    bMatchSettingChanged |= ImGui::InputInt("##sysSpeed", &mSetting.draftInterval);
     ImGui::Text("Time per match: ");
-    ImGui::InputInt("##duration", &mSetting.matchDuration);
+    bMatchSettingChanged |= ImGui::InputInt("##duration", &mSetting.matchDuration);
     //ImGui::Text("# Match/Cycle: ");
     //ImGui::InputInt("##matchPerCycle", &Setting.matchesPerCycle);
-    mmSystem->SetMatchSetting(mSetting);
+    if (bMatchSettingChanged)
+    {
+        simRunner->PushCommand([mSetting](FShardCoordinator& coordinator) { coordinator.SetMatchSetting(mSetting); });
+    }
     
     ImGui::SeparatorText("Debugging");
     if (ImGui::Button("Validate player in game state"))
     {
-        std::vector<int> foundIllegalIds;
-        for (int i = 0; i < static_cast<int>(mmSystem->GetAllPlayers().size()); ++i)
+        const float maxGameTime = static_cast<float>(mSetting.matchDuration) * 1.5f;
+        simRunner->PushCommand([simRunner, maxGameTime](FShardCoordinator& coordinator)
         {
-            const auto& it_player = mmSystem->GetAllPlayers().find(i);
-            if (it_player != mmSystem->GetAllPlayers().end())
+            std::vector<std::pair<int, int>> foundIllegalIds; // shard, player id
+            for (int shard = 0; shard < coordinator.GetNumShards(); ++shard)
             {
-                if (it_player->second.GetState() == EPlayerState::InGame && it_player->second.GetTimeInCurrentState() > (static_cast<float>(mSetting.matchDuration) * 1.5f))
+                for (const VirtualPlayer& player : coordinator.GetShard(shard).GetAllPlayers())
                 {
-                    foundIllegalIds.push_back(it_player->second.GetId());
+                    if (player.GetState() == EPlayerState::InGame && player.GetTimeInCurrentState() > maxGameTime)
+                    {
+                        foundIllegalIds.push_back({shard, player.GetId()});
+                    }
                 }
             }
-        }
-        if (!foundIllegalIds.empty())
-        {
-            std::string idStr;
-            for (int id : foundIllegalIds)
+            if (!foundIllegalIds.empty())
             {
-                idStr += std::to_string(id) + " ";
+                std::string idStr;
+                for (const std::pair<int, int>& id : foundIllegalIds)
+                {
+                    idStr += std::to_string(id.first) + ":" + std::to_string(id.second) + " ";
+                }
+                simRunner->SetDebugText("Found players with excessive long game time:" + idStr);
             }
-            textDebugLogResult = "Found players with excessive long game time:" + idStr;
-        }
+        });
     }
 
     ImGui::BeginChild("Debug logging", ImVec2(0, 75), true);
-    ImGui::TextWrapped(textDebugLogResult.c_str());
+    ImGui::TextWrapped("%s", snapshot.debugText.c_str());
     ImGui::EndChild();
     
     ImGui::End();
 }
 
-void DrawStatusPanel(const MatchMakingSystem* mmSystem)
+void DrawStatusPanel(const FSimSnapshot& snapshot)
 {
     ImGui::Begin("Current Status");
 
     ImGui::SeparatorText("System Status");
-    ImGui::Text("Year %d, %d/%02d, %02d:%02d", WorldTime::GetYear(), WorldTime::GetMonth(), WorldTime::GetDay(), WorldTime::GetHour(), WorldTime::GetMinute());
-    ImGui::Text("%d", static_cast<int>(WorldTime::GetWorldTimeMillis()));
-    ImGui::Text("Total players: %d", static_cast<int>(mmSystem->GetAllPlayers().size()));
-    ImGui::Text("# of ongoing matches: %d", static_cast<int>(mmSystem->GetOngoingMatchIds().size()));
-    std::pair<int, int> timePair = WorldTime::conv_DayTimePair(static_cast<uint64_t>(mmSystem->GetAvgQueueTime()));
+    ImGui::Text("Year %d, %d/%02d, %02d:%02d", WorldTime::GetYearAt(snapshot.worldTime), WorldTime::GetMonthAt(snapshot.worldTime),
+        WorldTime::GetDayAt(snapshot.worldTime), WorldTime::GetHourAt(snapshot.worldTime), WorldTime::GetMinuteAt(snapshot.worldTime));
+    ImGui::Text("%d", static_cast<int>(snapshot.worldTime));
+    ImGui::Text("Total players: %d", snapshot.numPlayers);
+    ImGui::Text("# of ongoing matches: %d", snapshot.numOngoingMatches);
+    std::pair<int, int> timePair = WorldTime::conv_DayTimePair(static_cast<uint64_t>(snapshot.avgQueueTime));
     ImGui::Text("Average Queue time: %02d:%02d", timePair.first, timePair.second);
+    timePair = WorldTime::conv_DayTimePair(static_cast<uint64_t>(snapshot.avgGameTime));
+    ImGui::Text("Average Game time: %02d:%02d", timePair.first, timePair.second);
+    ImGui::Text("Event backlog: %d (peak %d)", static_cast<int>(snapshot.stateEventBacklog), static_cast<int>(snapshot.peakStateEventBacklog));
+    ImGui::Text("Event lateness avg %.1fms, p99 %.0fms, max %.0fms", snapshot.stateEventLatenessAvg,
+        snapshot.stateEventLatenessP99, snapshot.stateEventLatenessMax);
+
+    // one row per region, the list and detail panels show the selected one
+    ImGui::SeparatorText("Shards");
+    if (ImGui::BeginTable("Shards", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+    {
+        ImGui::TableNextRow();
+        const char* columnNames[] = {"Shard", "Players", "Queued", "Ongoing", "Avg queue", "Overflow out", "Overflow in"};
+        for (int c = 0; c < 7; ++c)
+        {
+            ImGui::TableSetColumnIndex(c);
+            ImGui::TextUnformatted(columnNames[c]);
+        }
+
+        for (int i = 0; i < static_cast<int>(snapshot.shards.size()); ++i)
+        {
+            const FShardSnapshot& shard = snapshot.shards[i];
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+            ImGui::PushStyleVar(ImGuiStyleVar_FrameBorderSize, requestedView.shardIndex == i ? 5.0f : 0.0f); // highlight current
+            char btnText[32];
+            (void)sprintf_s(btnText, "#%d", i);
+            if (ImGui::Button(btnText) && requestedView.shardIndex != i)
+            {
+                // player ids are per shard
+                requestedView.shardIndex = i;
+                requestedView.selectedPlayerId = -1;
+                requestedView.firstHistoryIndex = 0;
+            }
+            ImGui::PopStyleVar();
+            ImGui::TableSetColumnIndex(1);
+            ImGui::Text("%d", shard.numPlayers);
+            ImGui::TableSetColumnIndex(2);
+            ImGui::Text("%d", shard.numQueued);
+            ImGui::TableSetColumnIndex(3);
+            ImGui::Text("%d", shard.numOngoingMatches);
+            ImGui::TableSetColumnIndex(4);
+            timePair = WorldTime::conv_DayTimePair(static_cast<uint64_t>(shard.avgQueueTime));
+            ImGui::Text("%02d:%02d", timePair.first, timePair.second);
+            ImGui::TableSetColumnIndex(5);
+            ImGui::Text("%d", static_cast<int>(shard.playersSentOut));
+            ImGui::TableSetColumnIndex(6);
+            ImGui::Text("%d", static_cast<int>(shard.playersReceived));
+        }
+        ImGui::EndTable();
+    }
 
     ImGui::SeparatorText("Player Status");
-    std::vector<std::string> sortingOrder = {"ASC", "DSC"};
 
     // precalc order button size and location before the method buttons because they're on the same line
-    ImVec2 orderBtnSize = ImGui::CalcTextSize(bIsAscSort ? "ASC" : "DSC");
+    ImVec2 orderBtnSize = ImGui::CalcTextSize(requestedView.bAscending ? "ASC" : "DSC");
     float orderBtnLocation = ImGui::GetContentRegionAvail().x - orderBtnSize.x;
 
     // Draw sorting buttons
-    bool bSkipDelay = false;
     for (int i = 0; i < static_cast<int>(EPlayerSortingType::IterationRef); ++i)
     {
         EPlayerSortingType it_type = static_cast<EPlayerSortingType>(i);
@@ -140,12 +232,10 @@ void DrawStatusPanel(const MatchMakingSystem* mmSystem)
         
         if (display.isEnabled)
         {
-            ImGui::PushStyleVar(ImGuiStyleVar_FrameBorderSize, sortingType == it_type ? 5.0f : 0.0f); // highlight current
+            ImGui::PushStyleVar(ImGuiStyleVar_FrameBorderSize, requestedView.sortingType == it_type ? 5.0f : 0.0f); // highlight current
             if (ImGui::Button(display.abbrev.c_str()))
             {
-                sortingType = it_type;
-                bSkipDelay = true;
-                sortedPlayersForImPlot = mmSystem->GetSortedPlayerList(sortingType, true);
+                requestedView.sortingType = it_type;
             }
         }
         
@@ -154,19 +244,16 @@ void DrawStatusPanel(const MatchMakingSystem* mmSystem)
     }
 
     ImGui::SetCursorPosX(orderBtnLocation);
-    if (ImGui::Button(bIsAscSort ? "ASC" : "DSC"))
+    if (ImGui::Button(requestedView.bAscending ? "ASC" : "DSC"))
     {
-        bIsAscSort = !bIsAscSort;
-        bSkipDelay = true;
+        requestedView.bAscending = !requestedView.bAscending;
     }
     ImGui::Separator();
     
-    // Player entry list
-    GetPlayerList(mmSystem, currentPlayerList, bSkipDelay);
-    if (!currentPlayerList.empty())
+    // Player entry list, built by the runner for the view the snapshot was taken with
+    const std::vector<FPlayerListEntry>& playerList = snapshot.playerList;
+    if (!playerList.empty())
     {
-        FPlayerSortingTypeDisplay display = FPlayerSortingTypeDisplay(sortingType);
-
         if (ImGui::BeginTable("Player Display", 4, ImGuiTableFlags_NoBordersInBody))
         {
             for (int c = 0; c < 4; ++c)
@@ -175,7 +262,8 @@ void DrawStatusPanel(const MatchMakingSystem* mmSystem)
                 ImGui::TableSetupColumn(nullptr, ImGuiTableColumnFlags_WidthStretch, weight);
             }
             
-            for (int i = 0; i < (currentPlayerList.size() + 1) / 2; ++i)
+            const int numRows = static_cast<int>((playerList.size() + 1) / 2);
+            for (int i = 0; i < numRows; ++i)
             {
                 
                 ImGui::TableNextRow();
@@ -183,37 +271,35 @@ void DrawStatusPanel(const MatchMakingSystem* mmSystem)
                 {
                     ImGui::TableSetColumnIndex(c);
                     
-                    int index = (c >= 2) ? i + ((currentPlayerList.size() + 1) / 2) : i;
-                    if (index >= static_cast<int>(currentPlayerList.size()))
+                    int index = (c >= 2) ? i + numRows : i;
+                    if (index >= static_cast<int>(playerList.size()))
                     {
                         break;
                     }
                     
-                    const VirtualPlayer& cachedPlayer = currentPlayerList[index];
-                    auto it = mmSystem->GetAllPlayers().find(cachedPlayer.GetId());
-                    VirtualPlayer playerRef = it->second;
+                    const FPlayerListEntry& entry = playerList[index];
                 
                     if (c % 2 == 0) // on odd columns fill in player buttons
                     {
-                        ImGui::PushStyleVar(ImGuiStyleVar_FrameBorderSize, currentViewingPlayerId == playerRef.GetId() ? 5.0f : 0.0f); // highlight current
+                        ImGui::PushStyleVar(ImGuiStyleVar_FrameBorderSize, requestedView.selectedPlayerId == entry.id ? 5.0f : 0.0f); // highlight current
                         
                         ImVec4 btnColor;
-                        if (playerRef.GetState() == EPlayerState::InGame)
+                        if (entry.state == EPlayerState::InGame)
                         {
                             btnColor = ColorAsImVec4(EColor::Green_Dark);
                         }
                         else
                         {
-                            btnColor = playerRef.GetState() == EPlayerState::Offline ? ImVec4(btnColor.x / 2.0f, btnColor.y / 2.0f, btnColor.z / 2.0f, btnColor.w) : ImGui::GetStyleColorVec4(ImGuiCol_Button);
+                            btnColor = entry.state == EPlayerState::Offline ? ImVec4(btnColor.x / 2.0f, btnColor.y / 2.0f, btnColor.z / 2.0f, btnColor.w) : ImGui::GetStyleColorVec4(ImGuiCol_Button);
                         }
                         ImGui::PushStyleColor(ImGuiCol_Button, btnColor);
                             
                         char btnText[128];
-                        (void)sprintf_s(btnText, "ID: %d", cachedPlayer.GetId());
+                        (void)sprintf_s(btnText, "ID: %d", entry.id);
                         
                         if (ImGui::Button(btnText, {ImGui::GetContentRegionAvail().x, 0.0f}))
                         {
-                            currentViewingPlayerId = cachedPlayer.GetId();
+                            requestedView.selectedPlayerId = entry.id;
                         }
 
                         ImGui::PopStyleColor();
@@ -221,10 +307,7 @@ void DrawStatusPanel(const MatchMakingSystem* mmSystem)
                     }
                     else
                     {
-                        char format[128];
-                        (void)sprintf_s(format, display.format);
-                        
-                        ImGui::Text("%.2f", static_cast<float>(cachedPlayer.GetStatByTypeForSort(sortingType))); // displaying the individual 
+                        ImGui::Text("%.2f", static_cast<float>(entry.sortValue)); // displaying the individual 
                     }
                 }
             }
@@ -232,21 +315,21 @@ void DrawStatusPanel(const MatchMakingSystem* mmSystem)
         }
 
         // in the first instance when player count goes above 0, auto select the top player for better UX
-        if (currentViewingPlayerId < 0)
+        if (requestedView.selectedPlayerId < 0)
         {
-            currentViewingPlayerId = currentPlayerList[0].GetId();
+            requestedView.selectedPlayerId = playerList[0].id;
         }
     }
     ImGui::End();
 }
 
-void DrawPlayerDetail(const MatchMakingSystem* mmSystem)
+void DrawPlayerDetail(const FSimSnapshot& snapshot)
 {
     ImGui::Begin("Player detail");
 
-    if (currentViewingPlayerId > -1)
+    if (snapshot.selectedPlayer.id > -1)
     {
-        MakePlayerEntry(mmSystem, mmSystem->GetAllPlayers().find(currentViewingPlayerId)->second);
+        MakePlayerEntry(snapshot, snapshot.selectedPlayer);
     }
     else
     {
@@ -256,16 +339,16 @@ void DrawPlayerDetail(const MatchMakingSystem* mmSystem)
     ImGui::End();
 }
 
-void MakePlayerEntry(const MatchMakingSystem* mmSystem, const VirtualPlayer& player)
+void MakePlayerEntry(const FSimSnapshot& snapshot, const FPlayerDetailSnapshot& player)
 {
     // Player info
     ImGui::SeparatorText("General Info");
-    ImGui::Text("Player ID: %d", player.GetId());
-    std::pair<int, int> timePair = WorldTime::conv_DayTimePair(player.GetTimeInCurrentState());
-    ImGui::Text("is [%s] for %02d:%02d", ToString(player.GetState()).c_str(), timePair.first, timePair.second);
+    ImGui::Text("Player ID: %d (shard %d)", player.id, snapshot.view.shardIndex);
+    std::pair<int, int> timePair = WorldTime::conv_DayTimePair(player.timeInCurrentState);
+    ImGui::Text("is [%s] for %02d:%02d", ToString(player.state).c_str(), timePair.first, timePair.second);
     
     // Day life timeline
-    MakePlayerTimeLine(player);
+    MakePlayerTimeLine(player.desiredOnlineTimes, snapshot.worldTime);
     
     // draw traits
     ImGui::SeparatorText("Player Stats");
@@ -273,8 +356,8 @@ void MakePlayerEntry(const MatchMakingSystem* mmSystem, const VirtualPlayer& pla
     for (uint32_t bit = 1; bit <= static_cast<uint32_t>(EPlayerTrait::AllTraits); bit <<= 1)
     {
         auto TraitPair = TraitDatabase.find(static_cast<EPlayerTrait>(bit));
-        FTraitInfo TraitInfo = TraitPair->second;
-        if (player.HasTrait(TraitPair->first))
+        const FTraitInfo& TraitInfo = TraitPair->second;
+        if (HasTrait(player.traits, TraitPair->first))
         {
             FColor c = GetColor(TraitRarityLookup.find(TraitInfo.rarity)->second.color);
             ImGui::TextColored(ColorAsImVec4(c), (TraitPair->second.displayName + " ").c_str());
@@ -302,80 +385,76 @@ void MakePlayerEntry(const MatchMakingSystem* mmSystem, const VirtualPlayer& pla
         }
 
         ImGui::TableNextRow();
-        int values[] = {
-            player.GetAgr(), player.GetFle(), player.GetGri(),
-            player.GetEdr(), player.GetIns(), player.GetCre(), player.GetPre()
-        };
         for (int i = 0; i < 7; ++i)
         {
             ImGui::TableSetColumnIndex(i);
-            ImGui::Text("%d", values[i]);
+            ImGui::Text("%d", player.stats[i]);
         }
 
         ImGui::EndTable();
     }
 
+    // standing in the whole population for the selected sorting type
+    FPlayerSortingTypeDisplay rankDisplay = FPlayerSortingTypeDisplay(snapshot.view.sortingType);
+    ImGui::Text("%s rank: %d / %d (percentile %.1f)", rankDisplay.abbrev.c_str(),
+        player.rank + 1, snapshot.shards[snapshot.view.shardIndex].numPlayers, player.percentile * 100.0);
+
     ImGui::NewLine();
 
     ImGui::SeparatorText("Ongoing Match");
-    if (player.GetState() == EPlayerState::InGame && player.GetOngoingMatchId() >= 0)
+    if (player.state == EPlayerState::InGame && player.bHasOngoingMatch)
     {
-        auto it = mmSystem->GetAllMatches().find(player.GetOngoingMatchId());
-        if (it != mmSystem->GetAllMatches().end())
-        {
-            MakeMatchEntry_PlayerCentric(player, it->second);
-        }
-        else
-        {
-            ImGui::Text("No match ongoing");
-        }
+        MakeMatchEntry_PlayerCentric(player.id, player.ongoingMatch);
     }
-    else if(player.GetState() == EPlayerState::InGame && player.GetOngoingMatchId() < 0)
+    else if (player.state == EPlayerState::InGame)
     {
-        std::cout << "no match available on player " << player.GetId() << "\n";
+        ImGui::Text("No match ongoing");
     }
 
     ImGui::SeparatorText("Activity Log");
     ImGui::BeginChild("Activity Log", ImVec2(0, 100), true);
-    bool maxedOut = player.GetActivityLog().size() > 100;
-    int begin = maxedOut ? player.GetActivityLog().size() - 100 : 0;
-    int end = player.GetActivityLog().size();
-    for ( int i = begin; i < end - 1; ++i)
+    const FActivityLog& activityLog = player.activityLog;
+    if (!FActivityLog::IsEnabled())
+    {
+        ImGui::Text("activity log disabled");
+    }
+    for (size_t i = 0; i < activityLog.Size(); ++i)
     {
-        ImGui::Text(player.GetActivityLog()[i].c_str());
+        ImGui::TextUnformatted(FActivityLog::Format(activityLog[i]).c_str());
     }
     ImGui::EndChild();
     
     // Match history and general info
     ImGui::SeparatorText("Match History");
-    ImGui::Text("W: %d, L: %d", static_cast<int>(player.GetWonMatches().size()), static_cast<int>(player.GetLostMatches().size()));
-    ImGui::Text("Total Online Time: %.2f", static_cast<float>(player.GetOnlineTime())/1000.0f);
-    timePair = WorldTime::conv_DayTimePair(static_cast<uint64_t>(player.GetAvgQueueTime()));
+    ImGui::Text("W: %d, L: %d", player.numWon, player.numLost);
+    ImGui::Text("Total Online Time: %.2f", static_cast<float>(player.onlineTime)/1000.0f);
+    timePair = WorldTime::conv_DayTimePair(static_cast<uint64_t>(player.avgQueueTime));
     ImGui::Text("Average Queue Time: %02d:%02d", timePair.first, timePair.second);
-    timePair = WorldTime::conv_DayTimePair(static_cast<uint64_t>(player.GetAvgGameTime()));
+    timePair = WorldTime::conv_DayTimePair(static_cast<uint64_t>(player.avgGameTime));
     ImGui::Text("Average Game Time: %02d:%02d", timePair.first, timePair.second);
     
-    if (player.GetMatchHistory().empty())
+    if (player.numMatchesPlayed == 0)
     {
         ImGui::Text("No matches available.");
     }
     else
     {
-        ImGui::Text("Matches completed: %d", static_cast<int>(player.GetMatchHistory().size()));
+        ImGui::Text("Matches completed: %d", player.numMatchesPlayed);
         ImGui::Text("Display up to 5 from: ");
         ImGui::SameLine();
         ImGui::PushItemWidth(100.0f);
-        if (ImGui::SliderInt("##matchDisplayStart", &matchDisplayIndex,
-            0, static_cast<int>(player.GetMatchHistory().size() - 1),
+        if (ImGui::SliderInt("##matchDisplayStart", &requestedView.firstHistoryIndex,
+            0, player.numMatchesPlayed - 1,
             "match id: %d"))
         {
-            matchDisplayIndex = std::clamp(matchDisplayIndex, 0, static_cast<int>(player.GetMatchHistory().size() - 1));
+            requestedView.firstHistoryIndex = std::clamp(requestedView.firstHistoryIndex, 0, player.numMatchesPlayed - 1);
         }
         ImGui::PopItemWidth();
 
-        int lastIndex = (std::min)(matchDisplayIndex + 5, static_cast<int>(player.GetMatchHistory().size()));
-        for (int i = matchDisplayIndex; i < lastIndex; ++i)
+        // the runner copied this page of the history with the snapshot
+        for (size_t k = 0; k < player.historyIds.size(); ++k)
         {
+            const int i = snapshot.view.firstHistoryIndex + static_cast<int>(k);
             if (matchListHeaderState.find(i) == matchListHeaderState.end())
             {
                 matchListHeaderState[i] = false;
@@ -383,23 +462,27 @@ void MakePlayerEntry(const MatchMakingSystem* mmSystem, const VirtualPlayer& pla
 
             ImGui::SetNextItemOpen(matchListHeaderState[i]);
 
-            FMatch match = mmSystem->GetAllMatches().find(player.GetMatchHistory()[i])->second;
-            matchListHeaderState[i] = MakeMatchEntry_PlayerCentric(player, match);
+            if (player.historyMatches[k].matchId < 0)
+            {
+                ImGui::TextDisabled("ID: %d (no longer archived)", player.historyIds[k]);
+                continue;
+            }
+            matchListHeaderState[i] = MakeMatchEntry_PlayerCentric(player.id, player.historyMatches[k]);
         }
     }
 }
 
-bool MakeMatchEntry_PlayerCentric(const VirtualPlayer& player, const FMatch& match)
+bool MakeMatchEntry_PlayerCentric(int playerId, const FMatch& match)
 {
     bool bEntryOpened = false;
 
-    EColor HeaderColor = match.GetState() == EMatchState::Ongoing ? EColor::Gold : match.IsPlayerWinner(player.GetId()) ? EColor::Green_Dark : EColor::Red_Dark;
+    EColor HeaderColor = match.GetState() == EMatchState::Ongoing ? EColor::Gold : match.IsPlayerWinner(playerId) ? EColor::Green_Dark : EColor::Red_Dark;
     ImGui::PushStyleColor(ImGuiCol_Header, ColorAsImVec4(HeaderColor));
     
     if (ImGui::CollapsingHeader(("["+ ToString(match.GetState()) +"] ID: " + std::to_string(match.matchId)).c_str()))
     {
         bEntryOpened = true;
-        int numOfTeams = static_cast<int>(match.teams.size());
+        int numOfTeams = match.GetNumTeams();
 
         std::pair<int, int> timePair = WorldTime::conv_DayTimePair(match.matchDuration);
         ImGui::Text("Duration: %02d:%02d", timePair.first, timePair.second);
@@ -411,19 +494,19 @@ bool MakeMatchEntry_PlayerCentric(const VirtualPlayer& player, const FMatch& mat
         {
             ImGui::Text("Team %d: ", t);
             ImGui::SameLine();
-            for (size_t p = 0; p < match.teams[t].size(); ++p)
+            for (int p = 0; p < match.GetTeamSize(t); ++p)
             {
-                const VirtualPlayer& pl = match.teams[t][p];
-                if (pl.GetId() == player.GetId())
+                const int plId = match.GetPlayerId(t, p);
+                if (plId == playerId)
                 {
-                    ImGui::TextColored(ColorAsImVec4(EColor::Gold),"[%d]", pl.GetId());
+                    ImGui::TextColored(ColorAsImVec4(EColor::Gold),"[%d]", plId);
                 }
                 else
                 {
-                    ImGui::Text("[%d]", pl.GetId());
+                    ImGui::Text("[%d]", plId);
                 }
                 
-                if (p < match.teams[t].size() - 1)
+                if (p < match.GetTeamSize(t) - 1)
                 {
                     ImGui::SameLine();
                     ImGui::Text("+");
@@ -439,7 +522,7 @@ bool MakeMatchEntry_PlayerCentric(const VirtualPlayer& player, const FMatch& mat
 
         ImGui::NewLine();
 
-        if (ImGui::BeginTable("Predicted prob", static_cast<int>(match.teams.size()), ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+        if (ImGui::BeginTable("Predicted prob", numOfTeams, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
         {
             ImGui::TableNextRow();
             for (int i = 0; i < numOfTeams; ++i)
@@ -463,35 +546,32 @@ bool MakeMatchEntry_PlayerCentric(const VirtualPlayer& player, const FMatch& mat
     return bEntryOpened;
 }
 
-void DrawStatsGraph(const MatchMakingSystem* mmSystem)
+void DrawStatsGraph(const FSimSnapshot& snapshot)
 {
     ImGui::Begin("Win Rate vs Modifiers graph");
-    const std::unordered_map<int, VirtualPlayer>& playerList = mmSystem->GetAllPlayers();
     
-    if (playerList.size() < 10)
+    if (snapshot.numPlayers < 10)
     {
         ImGui::Text("Not enough player pool (10)");
     }
     else if (ImPlot::BeginPlot("Sorted player graph"))
     {
-        // We want to plot out all players so this is an expensive execution. Add a delay that's long enough or we should async this?
-        if (CheckUpdateDelay_RealTime(playerPlotUpdateDelay, lastPlayerPlotUpdateTime))
+        // the snapshot's list, plotted from the lowest value up whatever order the list view uses
+        std::vector<double> yData;
+        yData.reserve(snapshot.playerList.size());
+        for (const FPlayerListEntry& entry : snapshot.playerList)
         {
-            sortedPlayersForImPlot = mmSystem->GetSortedPlayerList(sortingType, true);
-            SIMPLOG(PlotSort, "Player plot updated!")
+            yData.push_back(entry.sortValue);
         }
-        std::vector<double> yData;
-        yData.reserve(sortedPlayersForImPlot.size());
-
-        for (const VirtualPlayer& p : sortedPlayersForImPlot)
+        if (!snapshot.view.bAscending)
         {
-            yData.push_back(p.GetStatByTypeForSort(sortingType));
+            std::reverse(yData.begin(), yData.end());
         }
 
         // auto fix X because player count is fixed
         ImPlot::SetupAxis(ImAxis_X1, nullptr, ImPlotAxisFlags_AutoFit);
         
-        FPlayerSortingTypeDisplay display = FPlayerSortingTypeDisplay(sortingType);
+        FPlayerSortingTypeDisplay display = FPlayerSortingTypeDisplay(snapshot.view.sortingType);
         if(display.bAutoFit)
         {
             ImPlot::SetupAxis(ImAxis_Y1, nullptr, ImPlotAxisFlags_AutoFit);
@@ -509,11 +589,11 @@ void DrawStatsGraph(const MatchMakingSystem* mmSystem)
     ImGui::End();
 }
 
-void DrawPlayerStatusGraph(const MatchMakingSystem* mmSystem)
+void DrawPlayerStatusGraph(const FSimSnapshot& snapshot)
 {
     ImGui::Begin("Status Graph");
 
-    int total = static_cast<int>(mmSystem->GetAllPlayers().size());
+    int total = snapshot.numPlayers;
     if (total > 0)
     {
         for (int i = 1; i < static_cast<int>(EPlayerState::IterationRef); ++i)
@@ -522,7 +602,7 @@ void DrawPlayerStatusGraph(const MatchMakingSystem* mmSystem)
             ImGui::Text("%s", ToString(state).c_str());
             ImGui::SameLine();
             
-            int count = mmSystem->GetNumPlayerOfState(state);
+            int count = snapshot.playersPerState[i];
             ImGui::SetCursorPosX(100.0f);
             ImGui::ProgressBar(static_cast<float>(count)/static_cast<float>(total), ImVec2(0.0f, 15.0f));
         }
@@ -531,13 +611,22 @@ void DrawPlayerStatusGraph(const MatchMakingSystem* mmSystem)
     ImGui::End();
 }
 
-void GetPlayerList(const MatchMakingSystem* mmSystem, std::vector<VirtualPlayer>& listRef, bool bSkipDelay)
+ImVec4 ColorAsImVec4(FColor color)
 {
-    //if (!CheckUpdateDelay_RealTime(playerListUpdateDelay, lastPlayerListUpdateTime) && !bSkipDelay) return;
-    listRef = mmSystem->GetSortedPlayerList(sortingType, bIsAscSort);
+    return {
+        static_cast<float>(color.r) / 255,
+        static_cast<float>(color.g) / 255,
+        static_cast<float>(color.b) / 255,
+        static_cast<float>(color.a) / 255
+    };
 }
 
-void MakePlayerTimeLine(const VirtualPlayer& player, bool bShowCurrentTime)
+ImVec4 ColorAsImVec4(EColor colorName)
+{
+    return ColorAsImVec4(GetColor(colorName));
+}
+
+void MakePlayerTimeLine(const std::vector<std::pair<uint64_t, uint64_t>>& desiredOnlineTimes, uint64_t worldTime, bool bShowCurrentTime)
 {
     ImVec2 p = ImGui::GetCursorScreenPos();
     ImDrawList* drawList = ImGui::GetWindowDrawList();
@@ -554,7 +643,7 @@ void MakePlayerTimeLine(const VirtualPlayer& player, bool bShowCurrentTime)
     drawList->AddRectFilled(ImVec2(startX, startY), ImVec2(endX, endY), IM_COL32(50, 50, 50, 255));
 
     // Draw sections
-    for (const std::pair<uint64_t, uint64_t>& section : player.GetDesiredOnlineTimes())
+    for (const std::pair<uint64_t, uint64_t>& section : desiredOnlineTimes)
     {
         float sectionStartX = startX + WorldTime::GetDayProgress(section.first) * len;
         float sectionEndX = startX + WorldTime::GetDayProgress(section.second) * len;
@@ -564,35 +653,27 @@ void MakePlayerTimeLine(const VirtualPlayer& player, bool bShowCurrentTime)
 
     if (bShowCurrentTime)
     {
-        float sectionStartX = startX + WorldTime::GetDayProgress() * len - 2.0f;
-        float sectionEndX = startX + WorldTime::GetDayProgress() * len + 2.0f;
+        float sectionStartX = startX + WorldTime::GetDayProgress(worldTime) * len - 2.0f;
+        float sectionEndX = startX + WorldTime::GetDayProgress(worldTime) * len + 2.0f;
         drawList->AddRectFilled(ImVec2(sectionStartX, startY), ImVec2(sectionEndX, endY), IM_COL32(150, 20, 20, 255));
     }
     
     ImGui::Dummy(ImVec2(len, height + 5));
 }
 
-void DrawDebug(const MatchMakingSystem* mmSystem)
+void DrawDebug(const FSimSnapshot& snapshot)
 {
     ImGui::Begin("Debug draw");
     
     if (ImPlot::BeginPlot("Sorted player graph"))
     {
-        const std::vector<std::vector<VirtualPlayer*>> pools = mmSystem->GetDraftedPools();
-        if (!pools.empty())
+        const std::vector<int>& poolSizes = snapshot.draftedPoolSizes;
+        if (!poolSizes.empty())
         {
-            std::vector<int> yData;
-            yData.reserve(pools.size());
-
-            for (const auto& p : pools)
-            {
-                yData.push_back(static_cast<int>(p.size()));
-            }
-
             //ImPlot::SetupAxis(ImAxis_X1, nullptr, ImPlotAxisFlags_AutoFit);
             //ImPlot::SetupAxis(ImAxis_Y1, nullptr, ImPlotAxisFlags_AutoFit);
 
-            ImPlot::PlotBars("pools", yData.data(), static_cast<int>(yData.size()));
+            ImPlot::PlotBars("pools", poolSizes.data(), static_cast<int>(poolSizes.size()));
         }
         ImPlot::EndPlot();
     }
@@ -10,28 +10,27 @@
 
 #include "imgui.h"
 #include "implot.h"
-#include "MatchMakingSystem.h"
+#include "SimulationRunner.h"
 
-class MatchMakingSystem;
-class VirtualPlayer;
+class FSimulationRunner;
 extern float COLOR_CLEAR[4];
 
-// ImGui Rendering
-void DrawMMUI(MatchMakingSystem* mmSystem);
+// ImGui Rendering. Panels only read the runner's latest snapshot, changes go to the simulation thread as commands
+void DrawMMUI(FSimulationRunner* simRunner);
 
 // MMSystem UI
-void DrawControlPanel(MatchMakingSystem* mmSystem); // the only panel that has access to change the mmSystem settings (or should we move that out too?)
-void DrawStatusPanel(const MatchMakingSystem* mmSystem);
-void DrawStatsGraph(const MatchMakingSystem* mmSystem);
-void DrawPlayerDetail(const MatchMakingSystem* mmSystem);
-void DrawPlayerStatusGraph(const MatchMakingSystem* mmSystem);
-void DrawDebug(const MatchMakingSystem* mmSystem);
+void DrawControlPanel(FSimulationRunner* simRunner, const FSimSnapshot& snapshot); // the only panel that has access to change the mmSystem settings (or should we move that out too?)
+void DrawStatusPanel(const FSimSnapshot& snapshot);
+void DrawStatsGraph(const FSimSnapshot& snapshot);
+void DrawPlayerDetail(const FSimSnapshot& snapshot);
+void DrawPlayerStatusGraph(const FSimSnapshot& snapshot);
+void DrawDebug(const FSimSnapshot& snapshot);
 
 // Virtual Player Display
-void MakePlayerEntry(const MatchMakingSystem* mmSystem, const VirtualPlayer& player);
-bool MakeMatchEntry_PlayerCentric(const VirtualPlayer& player, const FMatch& match);
-void MakePlayerTimeLine(const VirtualPlayer& player, bool bShowCurrentTime = true);
+void MakePlayerEntry(const FSimSnapshot& snapshot, const FPlayerDetailSnapshot& player);
+bool MakeMatchEntry_PlayerCentric(int playerId, const FMatch& match);
+void MakePlayerTimeLine(const std::vector<std::pair<uint64_t, uint64_t>>& desiredOnlineTimes, uint64_t worldTime, bool bShowCurrentTime = true);
 
 // Utility
-void GetPlayerList(const MatchMakingSystem* mmSystem, std::vector<VirtualPlayer>& listRef, bool bSkipDelay);
-
+ImVec4 ColorAsImVec4(FColor color);
+ImVec4 ColorAsImVec4(EColor colorName);
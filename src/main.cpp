@@ -17,6 +17,8 @@
 #include <SDL3/SDL.h>
 
 #include "MatchMakingSystem.h"
+#include "ShardCoordinator.h"
+#include "SimulationRunner.h"
 #include "UIConstructor.h"
 
 #ifdef __EMSCRIPTEN__
@@ -56,8 +58,14 @@ int main(int, char**)
     uint64_t seed = std::chrono::steady_clock::now().time_since_epoch().count(); // random seed, FIXME: support seed input later
     SeedRandomGenerator(seed);
 
-    // Init MM system
-    MatchMakingSystem* MMSim = new MatchMakingSystem(LIFO);
+    // Init MM system, it runs on its own thread from here on and the UI only sees its snapshots
+    FShardSetting shardSetting; // a single region, raise numShards to split the population
+    FShardCoordinator* MMSim = new FShardCoordinator(shardSetting, LIFO, seed);
+    FWorldSetting worldSetting = MMSim->GetWorldSetting();
+    worldSetting.eventBudgetMicros = 12000; // leave room in the 60Hz tick for commands and snapshots
+    MMSim->SetWorldSetting(worldSetting);
+    FSimulationRunner* simRunner = new FSimulationRunner(*MMSim);
+    simRunner->Start();
     
     // Setup Dear ImGui context
     IMGUI_CHECKVERSION();
@@ -113,12 +121,6 @@ int main(int, char**)
             continue;
         }
 
-        // World clock tick
-        GetWorldClock().Update();
-        
-        // system tick
-        MMSim->Update();
-        
         // Start the Dear ImGui frame
         ImGui_ImplSDLRenderer3_NewFrame();
         ImGui_ImplSDL3_NewFrame();
@@ -139,7 +141,7 @@ int main(int, char**)
         else
         {
             // UI tick
-            DrawMMUI(MMSim);
+            DrawMMUI(simRunner);
         }
         
         // Rendering
@@ -157,6 +159,10 @@ int main(int, char**)
 
     // Cleanup
     // [If using SDL_MAIN_USE_CALLBACKS: all code below would likely be your SDL_AppQuit() function]
+    simRunner->Stop();
+    delete simRunner;
+    delete MMSim;
+
     ImGui_ImplSDLRenderer3_Shutdown();
     ImGui_ImplSDL3_Shutdown();
     ImGui::DestroyContext();
@@ -0,0 +1,71 @@
+// Self checks for TSlotMap: handles stop resolving once their element is removed, and stay stale however often the
+// slot is reused.
+//
+// Usage: MatchMakerSlotMapTest
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "SlotMap.h"
+#include "TestCheck.h"
+
+static void TestSlotMapStaleHandles()
+{
+    std::printf("SlotMap stale handles\n");
+    TSlotMap<std::string> map;
+    CHECK(!map.Contains(FSlotHandle{}));
+    CHECK(map.Find(FSlotHandle{}) == nullptr);
+
+    const FSlotHandle a = map.Insert("a");
+    const FSlotHandle b = map.Insert("b");
+    const FSlotHandle c = map.Insert("c");
+
+    // removing b moves c into its dense slot, a and c must still resolve
+    CHECK(map.Remove(b));
+    CHECK(!map.Contains(b));
+    CHECK(map.Find(b) == nullptr);
+    CHECK(!map.Remove(b));
+    CHECK(map.Size() == 2);
+    CHECK(map.Find(a) && *map.Find(a) == "a");
+    CHECK(map.Find(c) && *map.Find(c) == "c");
+
+    // the freed slot is reused with a new generation, the old handle keeps failing
+    const FSlotHandle d = map.Insert("d");
+    CHECK(d.index == b.index);
+    CHECK(d != b);
+    CHECK(!map.Contains(b));
+    CHECK(map.Find(b) == nullptr);
+    CHECK(!map.Remove(b));
+    CHECK(map.Find(d) && *map.Find(d) == "d");
+    CHECK(map.Size() == 3);
+
+    // dense handles match the handles given out
+    for (size_t i = 0; i < map.Size(); ++i)
+    {
+        CHECK(map.Find(map.GetHandleAt(i)) == &map.GetAt(i));
+    }
+
+    // a slot removed and reused many times never accepts any earlier handle
+    std::vector<FSlotHandle> history = {d};
+    FSlotHandle current = d;
+    for (int i = 0; i < 100; ++i)
+    {
+        CHECK(map.Remove(current));
+        current = map.Insert(std::to_string(i));
+        CHECK(current.index == d.index);
+        history.push_back(current);
+    }
+    for (size_t i = 0; i + 1 < history.size(); ++i)
+    {
+        CHECK(!map.Contains(history[i]));
+    }
+    CHECK(map.Find(current) && *map.Find(current) == "99");
+    CHECK(map.Find(a) && *map.Find(a) == "a");
+}
+
+int main()
+{
+    TestSlotMapStaleHandles();
+    return FinishChecks();
+}
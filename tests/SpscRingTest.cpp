@@ -0,0 +1,105 @@
+// Self checks for TSpscRing: a full ring refuses writes until a slot is popped, and values cross threads in order.
+//
+// Usage: MatchMakerSpscRingTest
+
+#include <cstdio>
+#include <thread>
+
+#include "SpscRing.h"
+#include "TestCheck.h"
+
+static void TestSpscRingFull()
+{
+    std::printf("SpscRing full capacity\n");
+    TSpscRing<int> ring(5);
+    CHECK(ring.Capacity() == 8);
+    CHECK(ring.GetReadSlot() == nullptr);
+
+    // wraps the indices several times, filling the ring completely every round
+    int written = 0;
+    int read = 0;
+    for (int round = 0; round < 5; ++round)
+    {
+        for (size_t i = 0; i < ring.Capacity(); ++i)
+        {
+            int* slot = ring.GetWriteSlot();
+            CHECK(slot != nullptr);
+            if (slot == nullptr) return;
+            *slot = written++;
+            ring.Push();
+        }
+        CHECK(ring.Size() == ring.Capacity());
+        CHECK(ring.GetWriteSlot() == nullptr);
+
+        // one slot freed makes exactly one write possible
+        CHECK(*ring.GetReadSlot() == read++);
+        ring.Pop();
+        CHECK(ring.GetWriteSlot() != nullptr);
+        *ring.GetWriteSlot() = written++;
+        ring.Push();
+        CHECK(ring.GetWriteSlot() == nullptr);
+
+        while (int* slot = ring.GetReadSlot())
+        {
+            CHECK(*slot == read++);
+            ring.Pop();
+        }
+        CHECK(ring.Size() == 0);
+    }
+    CHECK(read == written);
+}
+
+// the producer keeps the ring full while the consumer drains it, every value arrives once and in order
+static void TestSpscRingThreads()
+{
+    std::printf("SpscRing producer and consumer threads\n");
+    TSpscRing<int> ring(4);
+    const int values = 200000;
+    int fullCount = 0;
+
+    std::thread producer([&]()
+    {
+        for (int value = 0; value < values;)
+        {
+            if (int* slot = ring.GetWriteSlot())
+            {
+                *slot = value++;
+                ring.Push();
+            }
+            else
+            {
+                ++fullCount;
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    int expected = 0;
+    bool bInOrder = true;
+    while (expected < values)
+    {
+        if (int* slot = ring.GetReadSlot())
+        {
+            bInOrder = bInOrder && *slot == expected;
+            ++expected;
+            ring.Pop();
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+
+    CHECK(bInOrder);
+    CHECK(ring.GetReadSlot() == nullptr);
+    CHECK(ring.Size() == 0);
+    std::printf("  ring was full %d times\n", fullCount);
+}
+
+int main()
+{
+    TestSpscRingFull();
+    TestSpscRingThreads();
+    return FinishChecks();
+}
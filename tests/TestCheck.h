@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdio>
+
+// Minimal checks for the self check executables: a failed check is printed and counted, the run goes on so one
+// execution reports every broken case. main returns FinishChecks() as the exit code CTest looks at
+inline int failedChecks = 0;
+
+#define CHECK(condition) \
+    do { if (!(condition)) { ++failedChecks; std::printf("  FAILED %s:%d: %s\n", __FILE__, __LINE__, #condition); } } while (0)
+
+inline int FinishChecks()
+{
+    if (failedChecks > 0)
+    {
+        std::printf("%d checks failed\n", failedChecks);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
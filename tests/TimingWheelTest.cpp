@@ -0,0 +1,204 @@
+// Self checks for TTimingWheel: entries come out in time order and never early across every level boundary, the
+// overflow list holds far entries until they are due, and capped extraction keeps the rest in order.
+//
+// Usage: MatchMakerTimingWheelTest [--seed <n>]
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "TestCheck.h"
+#include "TimingWheel.h"
+
+using FWheel = TTimingWheel<int>;
+
+// level 0 covers 2^8 ms, the top level 2^32 ms, everything past that starts in the overflow list
+static constexpr uint64_t LEVEL_SPAN[] = {1ULL << 8, 1ULL << 16, 1ULL << 24, 1ULL << 32};
+
+// extracts up to 'now' and checks the entries come out in time order, none of them early
+static void ExtractAndCheck(FWheel& wheel, uint64_t now, std::map<int, uint64_t>& pending, uint64_t& lastTime)
+{
+    std::vector<FWheel::FEntry> due;
+    wheel.ExtractDue(now, due);
+    for (const FWheel::FEntry& entry : due)
+    {
+        CHECK(entry.time <= now);
+        CHECK(entry.time >= lastTime);
+        CHECK(entry.payload == entry.handle * 3);
+        auto found = pending.find(entry.handle);
+        CHECK(found != pending.end() && found->second == entry.time);
+        if (found != pending.end()) { pending.erase(found); }
+        lastTime = std::max(lastTime, entry.time);
+    }
+
+    // nothing due may be left behind
+    for (const auto& [handle, time] : pending)
+    {
+        CHECK(time > now);
+    }
+    CHECK(wheel.Size() == pending.size());
+}
+
+static uint64_t GetModelNextTime(const std::map<int, uint64_t>& pending)
+{
+    uint64_t next = UINT64_MAX;
+    for (const auto& [handle, time] : pending) { next = std::min(next, time); }
+    return next;
+}
+
+static void TestTimingWheelLevelBoundaries()
+{
+    std::printf("TimingWheel level boundaries\n");
+    FWheel wheel;
+    std::map<int, uint64_t> pending;
+
+    // one entry on each side of every level boundary, plus a few in the overflow list, scheduled out of order
+    std::vector<uint64_t> times = {0, 1};
+    for (uint64_t span : LEVEL_SPAN)
+    {
+        times.push_back(span - 1);
+        times.push_back(span);
+        times.push_back(span + 1);
+        times.push_back(span * 3 - 1);
+    }
+    times.push_back(LEVEL_SPAN[3] * 5 + 17);
+    times.push_back(1ULL << 40);
+    std::reverse(times.begin(), times.end());
+
+    for (int handle = 0; handle < static_cast<int>(times.size()); ++handle)
+    {
+        wheel.Schedule(handle, times[handle], handle * 3);
+        pending[handle] = times[handle];
+    }
+    CHECK(wheel.Size() == times.size());
+    CHECK(wheel.GetNextTime() == 0);
+
+    // step just before and onto every boundary, the next time must always match the model
+    std::vector<uint64_t> steps = times;
+    for (uint64_t time : times) { if (time > 0) { steps.push_back(time - 1); } }
+    std::sort(steps.begin(), steps.end());
+
+    uint64_t lastTime = 0;
+    for (uint64_t now : steps)
+    {
+        ExtractAndCheck(wheel, now, pending, lastTime);
+        CHECK(wheel.GetNextTime() == GetModelNextTime(pending));
+    }
+    CHECK(wheel.IsEmpty());
+}
+
+static void TestTimingWheelOverflow()
+{
+    std::printf("TimingWheel overflow list\n");
+    FWheel wheel;
+    std::map<int, uint64_t> pending;
+    uint64_t lastTime = 0;
+
+    // far entries wait in the overflow list, one of them is cancelled and one is moved back into the wheel
+    const uint64_t far = 1ULL << 36;
+    const uint64_t times[] = {far + 2, far, far + LEVEL_SPAN[3], far + 1, 100};
+    for (int handle = 0; handle < 5; ++handle)
+    {
+        wheel.Schedule(handle, times[handle], handle * 3);
+        pending[handle] = times[handle];
+    }
+    CHECK(wheel.Cancel(3));
+    CHECK(!wheel.Cancel(3));
+    pending.erase(3);
+    wheel.Schedule(2, 5000, 6);
+    pending[2] = 5000;
+    CHECK(wheel.GetNextTime() == 100);
+
+    ExtractAndCheck(wheel, 10000, pending, lastTime);
+    CHECK(pending.size() == 2);
+    CHECK(wheel.GetNextTime() == far);
+    CHECK(wheel.CountDue(far - 1) == 0);
+
+    // nothing may come out of the overflow list before it is due, even across a top level wrap
+    ExtractAndCheck(wheel, far - 1, pending, lastTime);
+    CHECK(pending.size() == 2);
+    CHECK(wheel.CountDue(far + 2) == 2);
+
+    // an entry scheduled after the jump lands behind the overflow entries
+    wheel.Schedule(7, far + 3, 21);
+    pending[7] = far + 3;
+    ExtractAndCheck(wheel, far + 3, pending, lastTime);
+    CHECK(wheel.IsEmpty());
+    CHECK(wheel.GetNextTime() == UINT64_MAX);
+}
+
+// random schedules, reschedules and cancels against a model, with times spread over every level and the overflow list
+static void TestTimingWheelRandom(uint64_t seed)
+{
+    std::printf("TimingWheel random schedule\n");
+    std::mt19937_64 random(seed);
+    FWheel wheel;
+    std::map<int, uint64_t> pending;
+    uint64_t now = 0;
+    uint64_t lastTime = 0;
+
+    const int handles = 2000;
+    for (int round = 0; round < 200; ++round)
+    {
+        for (int op = 0; op < 100; ++op)
+        {
+            const int handle = static_cast<int>(random() % handles);
+            if (random() % 8 == 0)
+            {
+                CHECK(wheel.Cancel(handle) == (pending.erase(handle) == 1));
+                continue;
+            }
+
+            // pick the level first so far levels are hit as often as near ones
+            const uint64_t span = random() % 5 < 4 ? LEVEL_SPAN[random() % 4] : LEVEL_SPAN[3] * 4;
+            const uint64_t time = now + random() % span;
+            wheel.Schedule(handle, time, handle * 3);
+            pending[handle] = time;
+        }
+        CHECK(wheel.GetNextTime() == GetModelNextTime(pending));
+
+        // small steps most of the time, sometimes straight to the next entry
+        const uint64_t next = wheel.GetNextTime();
+        now = random() % 4 == 0 && next != UINT64_MAX ? next : now + random() % 1000;
+        lastTime = 0;
+        ExtractAndCheck(wheel, now, pending, lastTime);
+        now += 1;
+    }
+
+    // a capped extract keeps the rest for the next call, still in order
+    std::vector<FWheel::FEntry> due;
+    uint64_t previous = 0;
+    while (!wheel.IsEmpty())
+    {
+        due.clear();
+        wheel.ExtractDue(UINT64_MAX - 1, due, 7);
+        CHECK(!due.empty() && due.size() <= 7);
+        for (const FWheel::FEntry& entry : due)
+        {
+            CHECK(entry.time >= previous);
+            CHECK(pending.erase(entry.handle) == 1);
+            previous = entry.time;
+        }
+        if (due.empty()) break;
+    }
+    CHECK(pending.empty());
+}
+
+int main(int argc, char** argv)
+{
+    uint64_t seed = 12345;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::string(argv[i]) == "--seed") { seed = std::strtoull(argv[i + 1], nullptr, 10); }
+    }
+
+    TestTimingWheelLevelBoundaries();
+    TestTimingWheelOverflow();
+    TestTimingWheelRandom(seed);
+    return FinishChecks();
+}